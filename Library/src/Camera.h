@@ -32,12 +32,16 @@ namespace dae
 		float totalYaw{};
 
 		const float movementSpeed{ 10.f };
+		// set whenever origin or forward changes, the view matrix is only rebuilt then
 		bool updateONB{ true };
 
 		Matrix invViewMatrix{};
 		Matrix viewMatrix{};
 		Matrix projectionMatrix{};
 
+		// incremented every time viewMatrix or projectionMatrix changes
+		uint32_t version{};
+
 		void Initialize(float _aspectRatio, float _fovAngle = 90.f, Vector3 _origin = {0.f,0.f,0.f})
 		{
 			fovAngle = _fovAngle;
@@ -50,27 +54,46 @@ namespace dae
 			//CalculateProjectionMatrix();
 		}
 
+		// places the camera without going through input, e.g. for scripted camera paths
+		void LookAt(const Vector3& _origin, const Vector3& target)
+		{
+			origin = _origin;
+			forward = (target - origin).Normalized();
+			updateONB = true;
+		}
+
 		void CalculateViewMatrix()
 		{
-			if (updateONB)
+			if (!updateONB)
 			{
-				forward.Normalize();
-				right = Vector3::Cross(Vector3::UnitY, forward);
-				right.Normalize();
-				up = Vector3::Cross(forward, right);
-				up.Normalize();
+				return;
 			}
+
+			forward.Normalize();
+			right = Vector3::Cross(Vector3::UnitY, forward);
+			right.Normalize();
+			up = Vector3::Cross(forward, right);
+			up.Normalize();
 			updateONB = false;
 
 			viewMatrix = Matrix::CreateLookAtLH(origin, forward, up);
+			++version;
 		}
 
 		void CalculateProjectionMatrix()
 		{
+			if (fov == m_ProjectionFov && aspectRatio == m_ProjectionAspectRatio)
+			{
+				return;
+			}
+
 			const float near{ 0.1f };
 			const float far{ 100.f };
 
 			projectionMatrix = Matrix::CreatePerspectiveFovLH(fov, aspectRatio, near, far);
+			m_ProjectionFov = fov;
+			m_ProjectionAspectRatio = aspectRatio;
+			++version;
 		}
 
 		void Update(Timer* pTimer)
@@ -140,5 +163,10 @@ namespace dae
 			CalculateViewMatrix();
 			CalculateProjectionMatrix();
 		}
+
+	private:
+		// parameters projectionMatrix was last built with
+		float m_ProjectionFov{};
+		float m_ProjectionAspectRatio{};
 	};
 }
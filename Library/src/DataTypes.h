@@ -24,19 +24,113 @@ namespace dae
 		Vector3 viewDirection{};
 	};
 
+	struct BoundingBox
+	{
+		Vector3 min{};
+		Vector3 max{};
+
+		// Arvo's method, the result encloses the transformed box
+		BoundingBox Transformed(const Matrix& m) const
+		{
+			BoundingBox result{ m.GetTranslation(), m.GetTranslation() };
+			for (int row{}; row < 3; ++row)
+			{
+				for (int column{}; column < 3; ++column)
+				{
+					const float a{ m[row][column] * min[row] };
+					const float b{ m[row][column] * max[row] };
+					result.min[column] += std::min(a, b);
+					result.max[column] += std::max(a, b);
+				}
+			}
+			return result;
+		}
+	};
+
+	struct BoundingSphere
+	{
+		Vector3 center{};
+		float radius{};
+
+		BoundingSphere Transformed(const Matrix& m) const
+		{
+			return { m.TransformPoint(center), radius * m.GetMaxScale() };
+		}
+	};
+
 	enum class PrimitiveTopology
 	{
 		TriangleList,
 		TriangleStrip
 	};
 
+	struct Meshlet
+	{
+		// ranges into Mesh::meshletVertices and Mesh::meshletTriangles (3 local indices per triangle)
+		uint32_t vertexOffset{};
+		uint32_t vertexCount{};
+		uint32_t triangleOffset{};
+		uint32_t triangleCount{};
+
+		// object space bounds
+		Vector3 center{};
+		float radius{};
+
+		// the whole meshlet faces away when dot(center - eye, coneAxis) >= coneCutoff * |center - eye| + radius
+		Vector3 coneAxis{};
+		float coneCutoff{ 1.f };
+	};
+
+	struct MeshInstance
+	{
+		// applied after Mesh::worldMatrix, so every instance shares the mesh's own animation
+		Matrix worldMatrix{};
+		ColorRGB tint{ colors::White };
+	};
+
+	struct MeshLOD
+	{
+		std::vector<uint32_t> indices{};
+
+		// largest object space deviation from the full resolution surface, measured against its quadrics and not the previous level
+		float error{};
+	};
+
 	struct Mesh
 	{
 		std::vector<Vertex> vertices{};
 		std::vector<uint32_t> indices{};
 		PrimitiveTopology primitiveTopology{ PrimitiveTopology::TriangleList };
 
+		// object space, see Utils::CalculateBounds
+		BoundingBox boundingBox{};
+		BoundingSphere boundingSphere{};
+
+		// optional, see MeshOptimizer::BuildMeshlets
+		std::vector<Meshlet> meshlets{};
+		std::vector<uint32_t> meshletVertices{};
+		std::vector<uint8_t> meshletTriangles{};
+
+		// optional coarser index buffers over the same vertices, see MeshSimplifier::BuildLODs
+		std::vector<MeshLOD> lods{};
+	};
+
+	// what a renderer keeps per mesh, the geometry itself is shared by every renderer drawing it
+	struct MeshRenderState
+	{
+		const Mesh* pMesh{ nullptr };
+
+		// optional, when set the mesh is drawn once per instance (triangle lists only)
+		std::vector<MeshInstance> instances{};
+
 		std::vector<Vertex_Out> vertices_out{};
+		std::vector<uint32_t> indices_out{};
 		Matrix worldMatrix{};
+
+		// bump after changing worldMatrix or instances, vertices_out is reused while nothing changed
+		uint32_t version{ 1 };
+		// runtime, the mesh and view versions vertices_out and indices_out were built for
+		uint32_t meshVersion_out{};
+		uint32_t viewVersion_out{};
 	};
 }
@@ -0,0 +1,42 @@
+#include "DynamicResolution.h"
+
+//Standard includes
+#include <algorithm>
+#include <cmath>
+
+namespace dae
+{
+	DynamicResolution::DynamicResolution(float targetMilliseconds, float minScale, float maxScale) :
+		m_TargetMilliseconds{ targetMilliseconds },
+		m_MinScale{ std::min(minScale, maxScale) },
+		m_MaxScale{ maxScale },
+		m_Scale{ maxScale }
+	{
+	}
+
+	float DynamicResolution::Update(float frameMilliseconds)
+	{
+		m_SmoothedMilliseconds = m_SmoothedMilliseconds == 0.f ? frameMilliseconds : m_SmoothedMilliseconds * 0.9f + frameMilliseconds * 0.1f;
+
+		// drop as soon as the budget is blown, only come back up with clear headroom
+		const bool isOverBudget{ m_SmoothedMilliseconds > m_TargetMilliseconds * 1.05f };
+		const bool hasHeadroom{ m_SmoothedMilliseconds < m_TargetMilliseconds * 0.8f };
+		if (!isOverBudget && !hasHeadroom)
+		{
+			return m_Scale;
+		}
+
+		const float idealScale{ m_Scale * std::sqrt(m_TargetMilliseconds / std::max(m_SmoothedMilliseconds, 0.01f)) };
+		float scale{ std::clamp(std::round(idealScale / SCALE_STEP) * SCALE_STEP, m_MinScale, m_MaxScale) };
+		// a step at a time upwards, heavy frames may jump down further
+		if (hasHeadroom) scale = std::min(scale, m_Scale + SCALE_STEP);
+
+		if (scale != m_Scale)
+		{
+			// what the smoothed time would have been at the new scale, so the correction isn't applied twice
+			m_SmoothedMilliseconds *= (scale * scale) / (m_Scale * m_Scale);
+			m_Scale = scale;
+		}
+		return m_Scale;
+	}
+}
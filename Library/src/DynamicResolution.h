@@ -0,0 +1,26 @@
+#pragma once
+
+namespace dae
+{
+	// Picks the render scale that keeps the frame time at a target. The rendered area, and roughly the frame time,
+	// grows with the square of the scale. Measured times are smoothed and the scale moves in steps with some slack
+	// around the target, so it doesn't change every frame. Every change costs a full redraw.
+	class DynamicResolution final
+	{
+	public:
+		DynamicResolution(float targetMilliseconds, float minScale = 0.5f, float maxScale = 1.f);
+
+		// feed the time of the last rendered frame, returns the scale for the next one
+		float Update(float frameMilliseconds);
+		float GetScale() const { return m_Scale; };
+
+		static constexpr float SCALE_STEP{ 1.f / 16.f };
+
+	private:
+		float m_TargetMilliseconds;
+		float m_MinScale;
+		float m_MaxScale;
+		float m_Scale;
+		float m_SmoothedMilliseconds{};
+	};
+}
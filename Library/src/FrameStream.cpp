@@ -0,0 +1,246 @@
+#include "FrameStream.h"
+#include "Maths.h"
+#include "RenderTarget.h"
+#include "ThreadPool.h"
+
+//Standard includes
+#include <algorithm>
+
+namespace dae
+{
+	namespace
+	{
+		inline uint8_t ToLuma(int r, int g, int b)
+		{
+			return uint8_t(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+		}
+
+		inline uint8_t ToChromaBlue(int r, int g, int b)
+		{
+			return uint8_t(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+		}
+
+		inline uint8_t ToChromaRed(int r, int g, int b)
+		{
+			return uint8_t(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+		}
+
+#ifdef DAE_USE_SSE2
+		// luma of 4 XRGB pixels as 32 bit lanes
+		inline __m128i ToLuma4(__m128i pixels)
+		{
+			const __m128i zero{ _mm_setzero_si128() };
+			// pixels are B, G, R, X in memory
+			const __m128i weights{ _mm_setr_epi16(25, 129, 66, 0, 25, 129, 66, 0) };
+			__m128i low{ _mm_madd_epi16(_mm_unpacklo_epi8(pixels, zero), weights) };
+			__m128i high{ _mm_madd_epi16(_mm_unpackhi_epi8(pixels, zero), weights) };
+			// B*25 + G*129 and R*66 sit next to each other, add them into the even lanes
+			low = _mm_add_epi32(low, _mm_srli_epi64(low, 32));
+			high = _mm_add_epi32(high, _mm_srli_epi64(high, 32));
+			const __m128i sums{ _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(low), _mm_castsi128_ps(high), _MM_SHUFFLE(2, 0, 2, 0))) };
+			return _mm_add_epi32(_mm_srai_epi32(_mm_add_epi32(sums, _mm_set1_epi32(128)), 8), _mm_set1_epi32(16));
+		}
+#endif
+	}
+
+	FrameStreamWriter::FrameStreamWriter(const std::string& path, FrameStreamFormat format, int width, int height, int framesPerSecond, size_t ringSize) :
+		m_pFile{ std::fopen(path.c_str(), "wb") },
+		m_Format{ format },
+		m_Width{ width },
+		m_Height{ height },
+		m_pThreadPool{ new ThreadPool(1) }
+	{
+		m_Slots.resize(std::max(ringSize, size_t{ 1 }));
+		for (int idx{}; idx < int(m_Slots.size()); ++idx)
+		{
+			m_Slots[idx].resize(size_t(width) * height);
+			m_FreeSlots.push_back(idx);
+		}
+
+		if (!m_pFile)
+		{
+			m_HasFailed = true;
+			return;
+		}
+
+		if (m_Format == FrameStreamFormat::Y4M)
+		{
+			// C420jpeg: chroma sits between the four luma samples it was averaged from
+			m_HasFailed = std::fprintf(m_pFile, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, framesPerSecond) < 0;
+		}
+	}
+
+	FrameStreamWriter::~FrameStreamWriter()
+	{
+		Flush();
+		delete m_pThreadPool;
+		if (m_pFile)
+		{
+			std::fclose(m_pFile);
+		}
+	}
+
+	bool FrameStreamWriter::IsOpen() const
+	{
+		std::lock_guard lock{ m_Mutex };
+		return !m_HasFailed;
+	}
+
+	bool FrameStreamWriter::Submit(const RenderTarget& renderTarget)
+	{
+		if (renderTarget.GetWidth() != m_Width || renderTarget.GetHeight() != m_Height)
+		{
+			return false;
+		}
+
+		int slotIdx{};
+		{
+			// the backpressure: wait for the reader instead of dropping frames
+			std::unique_lock lock{ m_Mutex };
+			m_SlotFreed.wait(lock, [this]() { return m_HasFailed || !m_FreeSlots.empty(); });
+			if (m_HasFailed)
+			{
+				return false;
+			}
+			slotIdx = m_FreeSlots.back();
+			m_FreeSlots.pop_back();
+		}
+
+		std::vector<uint32_t>& slot{ m_Slots[slotIdx] };
+		for (int y{}; y < m_Height; ++y)
+		{
+			std::copy(renderTarget.GetRow(y), renderTarget.GetRow(y) + m_Width, slot.data() + size_t(y) * m_Width);
+		}
+
+		m_pThreadPool->Enqueue([this, slotIdx]() { WriteFrame(slotIdx); });
+		return true;
+	}
+
+	void FrameStreamWriter::Flush()
+	{
+		std::unique_lock lock{ m_Mutex };
+		m_SlotFreed.wait(lock, [this]() { return m_FreeSlots.size() == m_Slots.size(); });
+		if (m_pFile)
+		{
+			std::fflush(m_pFile);
+		}
+	}
+
+	int FrameStreamWriter::GetFramesWritten() const
+	{
+		std::lock_guard lock{ m_Mutex };
+		return m_FramesWritten;
+	}
+
+	void FrameStreamWriter::WriteFrame(int slotIdx)
+	{
+		bool isWritten{ false };
+		if (IsOpen())
+		{
+			const uint32_t* pPixels{ m_Slots[slotIdx].data() };
+			if (m_Format == FrameStreamFormat::Y4M)
+			{
+				const size_t lumaSize{ size_t(m_Width) * m_Height };
+				const size_t chromaSize{ size_t((m_Width + 1) / 2) * ((m_Height + 1) / 2) };
+				m_Output.resize(6 + lumaSize + 2 * chromaSize);
+				std::copy_n("FRAME\n", 6, m_Output.data());
+				ConvertToYUV420(pPixels, m_Width, m_Height, m_Width, m_Output.data() + 6, m_Output.data() + 6 + lumaSize, m_Output.data() + 6 + lumaSize + chromaSize);
+			}
+			else
+			{
+				m_Output.resize(size_t(m_Width) * m_Height * 4);
+				ConvertToRGBA(pPixels, m_Width, m_Height, m_Width, m_Output.data());
+			}
+			isWritten = std::fwrite(m_Output.data(), 1, m_Output.size(), m_pFile) == m_Output.size();
+		}
+
+		std::lock_guard lock{ m_Mutex };
+		if (isWritten) ++m_FramesWritten;
+		else m_HasFailed = true;
+		m_FreeSlots.push_back(slotIdx);
+		m_SlotFreed.notify_all();
+	}
+
+	void FrameStreamWriter::ConvertToYUV420(const uint32_t* pPixels, int width, int height, int stride, uint8_t* pY, uint8_t* pU, uint8_t* pV)
+	{
+		for (int y{}; y < height; ++y)
+		{
+			const uint32_t* pRow{ pPixels + size_t(y) * stride };
+			uint8_t* pLumaRow{ pY + size_t(y) * width };
+			int x{};
+#ifdef DAE_USE_SSE2
+			for (; x + 8 <= width; x += 8)
+			{
+				const __m128i luma0{ ToLuma4(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow + x))) };
+				const __m128i luma1{ ToLuma4(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow + x + 4))) };
+				const __m128i luma16{ _mm_packs_epi32(luma0, luma1) };
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(pLumaRow + x), _mm_packus_epi16(luma16, luma16));
+			}
+#endif
+			for (; x < width; ++x)
+			{
+				uint8_t r{}, g{}, b{};
+				RenderTarget::GetRGB(pRow[x], r, g, b);
+				pLumaRow[x] = ToLuma(r, g, b);
+			}
+		}
+
+		// a quarter of the samples, not worth vectorizing
+		const int chromaWidth{ (width + 1) / 2 };
+		for (int cy{}; cy < (height + 1) / 2; ++cy)
+		{
+			const uint32_t* pRow0{ pPixels + size_t(cy * 2) * stride };
+			const uint32_t* pRow1{ pPixels + size_t(std::min(cy * 2 + 1, height - 1)) * stride };
+			for (int cx{}; cx < chromaWidth; ++cx)
+			{
+				const int x0{ cx * 2 };
+				const int x1{ std::min(cx * 2 + 1, width - 1) };
+				int r{}, g{}, b{};
+				for (const uint32_t pixel : { pRow0[x0], pRow0[x1], pRow1[x0], pRow1[x1] })
+				{
+					r += (pixel >> 16) & 0xff;
+					g += (pixel >> 8) & 0xff;
+					b += pixel & 0xff;
+				}
+				r = (r + 2) / 4;
+				g = (g + 2) / 4;
+				b = (b + 2) / 4;
+				pU[size_t(cy) * chromaWidth + cx] = ToChromaBlue(r, g, b);
+				pV[size_t(cy) * chromaWidth + cx] = ToChromaRed(r, g, b);
+			}
+		}
+	}
+
+	void FrameStreamWriter::ConvertToRGBA(const uint32_t* pPixels, int width, int height, int stride, uint8_t* pRGBA)
+	{
+		for (int y{}; y < height; ++y)
+		{
+			const uint32_t* pRow{ pPixels + size_t(y) * stride };
+			uint8_t* pOutRow{ pRGBA + size_t(y) * width * 4 };
+			int x{};
+#ifdef DAE_USE_SSE2
+			// swap R and B and set alpha, in memory B, G, R, X becomes R, G, B, A
+			const __m128i greenMask{ _mm_set1_epi32(0x0000ff00) };
+			const __m128i byteMask{ _mm_set1_epi32(0x000000ff) };
+			const __m128i alpha{ _mm_set1_epi32(int(0xff000000)) };
+			for (; x + 4 <= width; x += 4)
+			{
+				const __m128i pixels{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow + x)) };
+				const __m128i red{ _mm_and_si128(_mm_srli_epi32(pixels, 16), byteMask) };
+				const __m128i blue{ _mm_slli_epi32(_mm_and_si128(pixels, byteMask), 16) };
+				const __m128i rgba{ _mm_or_si128(_mm_or_si128(red, blue), _mm_or_si128(_mm_and_si128(pixels, greenMask), alpha)) };
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(pOutRow + size_t(x) * 4), rgba);
+			}
+#endif
+			for (; x < width; ++x)
+			{
+				uint8_t r{}, g{}, b{};
+				RenderTarget::GetRGB(pRow[x], r, g, b);
+				pOutRow[x * 4] = r;
+				pOutRow[x * 4 + 1] = g;
+				pOutRow[x * 4 + 2] = b;
+				pOutRow[x * 4 + 3] = 255;
+			}
+		}
+	}
+}
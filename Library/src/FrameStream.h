@@ -0,0 +1,72 @@
+#pragma once
+
+//Standard includes
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace dae
+{
+	class RenderTarget;
+	class ThreadPool;
+
+	enum class FrameStreamFormat
+	{
+		// YUV 4:2:0 with a text header, what ffmpeg -i pipe reads without further options
+		Y4M,
+		// 8 bit R, G, B, A per pixel and nothing else, needs -f rawvideo -pix_fmt rgba -s WxH on the reading side
+		RawRGBA
+	};
+
+	// Writes every submitted frame to a file or named pipe so an encoder can read the renders while they happen.
+	// Frames are copied into a ring of ringSize staging buffers, converted and written on a worker thread. When the
+	// reader falls behind and the ring is full, Submit waits, so frames are never dropped.
+	class FrameStreamWriter final
+	{
+	public:
+		FrameStreamWriter(const std::string& path, FrameStreamFormat format, int width, int height, int framesPerSecond = 60, size_t ringSize = 3);
+		// writes the queued frames and closes the stream
+		~FrameStreamWriter();
+
+		FrameStreamWriter(const FrameStreamWriter&) = delete;
+		FrameStreamWriter(FrameStreamWriter&&) noexcept = delete;
+		FrameStreamWriter& operator=(const FrameStreamWriter&) = delete;
+		FrameStreamWriter& operator=(FrameStreamWriter&&) noexcept = delete;
+
+		// false when the path couldn't be opened or a write failed, e.g. because the reader went away
+		bool IsOpen() const;
+		// the render target must have the stream's size
+		bool Submit(const RenderTarget& renderTarget);
+		void Flush();
+
+		int GetFramesWritten() const;
+
+		// BT.601 limited range, chroma averaged over 2x2 pixels. U and V are (width + 1) / 2 by (height + 1) / 2
+		static void ConvertToYUV420(const uint32_t* pPixels, int width, int height, int stride, uint8_t* pY, uint8_t* pU, uint8_t* pV);
+		static void ConvertToRGBA(const uint32_t* pPixels, int width, int height, int stride, uint8_t* pRGBA);
+
+	private:
+		void WriteFrame(int slotIdx);
+
+		std::FILE* m_pFile;
+		const FrameStreamFormat m_Format;
+		const int m_Width;
+		const int m_Height;
+
+		// staging copies of the render target, tightly packed
+		std::vector<std::vector<uint32_t>> m_Slots{};
+		// converted frame, only touched by the worker
+		std::vector<uint8_t> m_Output{};
+		ThreadPool* m_pThreadPool;
+
+		// guarded by m_Mutex
+		std::vector<int> m_FreeSlots{};
+		bool m_HasFailed{ false };
+		int m_FramesWritten{};
+		mutable std::mutex m_Mutex{};
+		std::condition_variable m_SlotFreed{};
+	};
+}
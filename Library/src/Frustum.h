@@ -0,0 +1,95 @@
+#pragma once
+#include "DataTypes.h"
+#include "Maths.h"
+
+namespace dae
+{
+	struct Plane
+	{
+		Vector3 normal{};
+		float distance{};
+
+		Plane() = default;
+		Plane(const Vector4& coefficients) :
+			normal{ coefficients.x, coefficients.y, coefficients.z },
+			distance{ coefficients.w }
+		{
+			const float length{ normal.Normalize() };
+			distance /= length;
+		}
+
+		float SignedDistance(const Vector3& point) const
+		{
+			return Vector3::Dot(normal, point) + distance;
+		}
+	};
+
+	struct Frustum
+	{
+		enum PlaneIndex { Left, Right, Bottom, Top, Near, Far };
+
+		// inside is the positive side of every plane
+		Plane planes[6]{};
+
+		// Gribb/Hartmann extraction, Matrix transforms row vectors so the planes come from its columns
+		static Frustum FromMatrix(const Matrix& m)
+		{
+			const Vector4 column0{ m[0].x, m[1].x, m[2].x, m[3].x };
+			const Vector4 column1{ m[0].y, m[1].y, m[2].y, m[3].y };
+			const Vector4 column2{ m[0].z, m[1].z, m[2].z, m[3].z };
+			const Vector4 column3{ m[0].w, m[1].w, m[2].w, m[3].w };
+
+			Frustum frustum{};
+			frustum.planes[Left] = Plane{ column3 + column0 };
+			frustum.planes[Right] = Plane{ column3 - column0 };
+			frustum.planes[Bottom] = Plane{ column3 + column1 };
+			frustum.planes[Top] = Plane{ column3 - column1 };
+			frustum.planes[Near] = Plane{ column2 }; // LH projection, depth range [0,1]
+			frustum.planes[Far] = Plane{ column3 - column2 };
+			return frustum;
+		}
+
+		bool IsSphereOutside(const Vector3& center, float radius) const
+		{
+			for (const Plane& plane : planes)
+			{
+				if (plane.SignedDistance(center) < -radius) return true;
+			}
+			return false;
+		}
+
+		bool IsSphereOutside(const BoundingSphere& sphere) const
+		{
+			return IsSphereOutside(sphere.center, sphere.radius);
+		}
+
+		// on the positive side of every plane with room to spare, nothing of it can be clipped or culled
+		bool IsSphereInside(const Vector3& center, float radius) const
+		{
+			for (const Plane& plane : planes)
+			{
+				if (plane.SignedDistance(center) < radius) return false;
+			}
+			return true;
+		}
+
+		bool IsSphereInside(const BoundingSphere& sphere) const
+		{
+			return IsSphereInside(sphere.center, sphere.radius);
+		}
+
+		bool IsBoxOutside(const BoundingBox& box) const
+		{
+			for (const Plane& plane : planes)
+			{
+				// corner furthest along the plane normal
+				const Vector3 corner{
+					plane.normal.x >= 0.f ? box.max.x : box.min.x,
+					plane.normal.y >= 0.f ? box.max.y : box.min.y,
+					plane.normal.z >= 0.f ? box.max.z : box.min.z };
+				if (plane.SignedDistance(corner) < 0.f) return true;
+			}
+			return false;
+		}
+	};
+}
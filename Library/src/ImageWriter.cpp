@@ -0,0 +1,237 @@
+#include "ImageWriter.h"
+#include "RenderTarget.h"
+#include "ThreadPool.h"
+#include <SDL_image.h>
+
+//Standard includes
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+
+namespace dae
+{
+	namespace
+	{
+		bool WriteFile(const std::string& path, const std::vector<uint8_t>& bytes)
+		{
+			std::ofstream file{ path, std::ios::binary };
+			file.write(reinterpret_cast<const char*>(bytes.data()), std::streamsize(bytes.size()));
+			return bool(file);
+		}
+
+		void PushBigEndian(std::vector<uint8_t>& bytes, uint32_t value)
+		{
+			bytes.push_back(uint8_t(value >> 24));
+			bytes.push_back(uint8_t(value >> 16));
+			bytes.push_back(uint8_t(value >> 8));
+			bytes.push_back(uint8_t(value));
+		}
+	}
+
+	ImageFormat ImageWriter::GetFormat(const std::string& path)
+	{
+		const size_t dotIdx{ path.find_last_of('.') };
+		std::string extension{ dotIdx == std::string::npos ? "" : path.substr(dotIdx + 1) };
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return char(std::tolower(c)); });
+
+		if (extension == "png") return ImageFormat::PNG;
+		if (extension == "qoi") return ImageFormat::QOI;
+		if (extension == "ppm") return ImageFormat::PPM;
+		return ImageFormat::BMP;
+	}
+
+	bool ImageWriter::Write(const uint32_t* pPixels, int width, int height, int stride, const std::string& path)
+	{
+		const ImageFormat format{ GetFormat(path) };
+		if (format == ImageFormat::QOI) return WriteFile(path, EncodeQOI(pPixels, width, height, stride));
+		if (format == ImageFormat::PPM) return WriteFile(path, EncodePPM(pPixels, width, height, stride));
+
+		SDL_Surface* pSurface{ SDL_CreateRGBSurfaceWithFormatFrom(const_cast<uint32_t*>(pPixels), width, height, 32, stride * int(sizeof(uint32_t)), SDL_PIXELFORMAT_RGB888) };
+		if (!pSurface)
+		{
+			return false;
+		}
+
+		const bool isSaved{ (format == ImageFormat::PNG ? IMG_SavePNG(pSurface, path.c_str()) : SDL_SaveBMP(pSurface, path.c_str())) == 0 };
+		SDL_FreeSurface(pSurface);
+		return isSaved;
+	}
+
+	bool ImageWriter::Write(const RenderTarget& renderTarget, const std::string& path)
+	{
+		return Write(renderTarget.GetPixels(), renderTarget.GetWidth(), renderTarget.GetHeight(), renderTarget.GetStride(), path);
+	}
+
+	std::vector<uint8_t> ImageWriter::EncodeQOI(const uint32_t* pPixels, int width, int height, int stride)
+	{
+		// https://qoiformat.org/qoi-specification.pdf, the alpha channel is always 255 so QOI_OP_RGBA is never needed
+		constexpr uint8_t opIndex{ 0x00 }, opDiff{ 0x40 }, opLuma{ 0x80 }, opRun{ 0xc0 }, opRGB{ 0xfe };
+
+		std::vector<uint8_t> bytes{ 'q', 'o', 'i', 'f' };
+		bytes.reserve(size_t(width) * height * 4 + 22);
+		PushBigEndian(bytes, uint32_t(width));
+		PushBigEndian(bytes, uint32_t(height));
+		bytes.push_back(3);
+		bytes.push_back(0);
+
+		// every seen pixel by hash, alpha 0 so no real pixel matches an empty slot
+		uint32_t seenPixels[64]{};
+		bool isSeen[64]{};
+		uint32_t previous{ 0 };
+		int run{};
+		for (int y{}; y < height; ++y)
+		{
+			const uint32_t* pRow{ pPixels + size_t(y) * stride };
+			for (int x{}; x < width; ++x)
+			{
+				const uint32_t pixel{ pRow[x] & 0xffffff };
+				if (pixel == previous)
+				{
+					if (++run == 62)
+					{
+						bytes.push_back(uint8_t(opRun | (run - 1)));
+						run = 0;
+					}
+					continue;
+				}
+				if (run > 0)
+				{
+					bytes.push_back(uint8_t(opRun | (run - 1)));
+					run = 0;
+				}
+
+				const uint8_t r{ uint8_t(pixel >> 16) }, g{ uint8_t(pixel >> 8) }, b{ uint8_t(pixel) };
+				const int hash{ (r * 3 + g * 5 + b * 7 + 255 * 11) % 64 };
+				if (isSeen[hash] && seenPixels[hash] == pixel)
+				{
+					bytes.push_back(uint8_t(opIndex | hash));
+				}
+				else
+				{
+					seenPixels[hash] = pixel;
+					isSeen[hash] = true;
+
+					const int8_t dr{ int8_t(r - uint8_t(previous >> 16)) };
+					const int8_t dg{ int8_t(g - uint8_t(previous >> 8)) };
+					const int8_t db{ int8_t(b - uint8_t(previous)) };
+					const int8_t drdg{ int8_t(dr - dg) };
+					const int8_t dbdg{ int8_t(db - dg) };
+					if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+					{
+						bytes.push_back(uint8_t(opDiff | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2)));
+					}
+					else if (dg >= -32 && dg <= 31 && drdg >= -8 && drdg <= 7 && dbdg >= -8 && dbdg <= 7)
+					{
+						bytes.push_back(uint8_t(opLuma | (dg + 32)));
+						bytes.push_back(uint8_t((drdg + 8) << 4 | (dbdg + 8)));
+					}
+					else
+					{
+						bytes.push_back(opRGB);
+						bytes.push_back(r);
+						bytes.push_back(g);
+						bytes.push_back(b);
+					}
+				}
+				previous = pixel;
+			}
+		}
+		if (run > 0)
+		{
+			bytes.push_back(uint8_t(opRun | (run - 1)));
+		}
+
+		bytes.insert(bytes.end(), { 0, 0, 0, 0, 0, 0, 0, 1 });
+		return bytes;
+	}
+
+	std::vector<uint8_t> ImageWriter::EncodePPM(const uint32_t* pPixels, int width, int height, int stride)
+	{
+		const std::string header{ "P6\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n" };
+		std::vector<uint8_t> bytes(header.begin(), header.end());
+		bytes.reserve(header.size() + size_t(width) * height * 3);
+		for (int y{}; y < height; ++y)
+		{
+			const uint32_t* pRow{ pPixels + size_t(y) * stride };
+			for (int x{}; x < width; ++x)
+			{
+				bytes.push_back(uint8_t(pRow[x] >> 16));
+				bytes.push_back(uint8_t(pRow[x] >> 8));
+				bytes.push_back(uint8_t(pRow[x]));
+			}
+		}
+		return bytes;
+	}
+
+	AsyncImageWriter::AsyncImageWriter(size_t maxPendingImages) :
+		m_pThreadPool{ new ThreadPool(1) },
+		m_MaxPendingImages{ std::max(maxPendingImages, size_t{ 1 }) }
+	{
+	}
+
+	AsyncImageWriter::~AsyncImageWriter()
+	{
+		Flush();
+		delete m_pThreadPool;
+		for (StagingImage* pImage : m_FreeImages)
+		{
+			delete pImage;
+		}
+	}
+
+	bool AsyncImageWriter::Capture(const RenderTarget& renderTarget, const std::string& path)
+	{
+		StagingImage* pImage{ nullptr };
+		{
+			std::lock_guard lock{ m_Mutex };
+			if (!m_FreeImages.empty())
+			{
+				pImage = m_FreeImages.back();
+				m_FreeImages.pop_back();
+			}
+			else if (m_ImageCount < m_MaxPendingImages)
+			{
+				pImage = new StagingImage{};
+				++m_ImageCount;
+			}
+			else
+			{
+				return false;
+			}
+			++m_PendingCount;
+		}
+
+		// the only work on the calling thread, one row copy per line
+		pImage->width = renderTarget.GetWidth();
+		pImage->height = renderTarget.GetHeight();
+		pImage->pixels.resize(size_t(pImage->width) * pImage->height);
+		for (int y{}; y < pImage->height; ++y)
+		{
+			std::copy(renderTarget.GetRow(y), renderTarget.GetRow(y) + pImage->width, pImage->pixels.data() + size_t(y) * pImage->width);
+		}
+
+		m_pThreadPool->Enqueue([this, pImage, path]()
+			{
+				const bool isWritten{ ImageWriter::Write(pImage->pixels.data(), pImage->width, pImage->height, pImage->width, path) };
+
+				std::lock_guard lock{ m_Mutex };
+				m_Results.emplace_back(path, isWritten);
+				m_FreeImages.push_back(pImage);
+				--m_PendingCount;
+				m_Finished.notify_all();
+			});
+		return true;
+	}
+
+	void AsyncImageWriter::Flush()
+	{
+		std::unique_lock lock{ m_Mutex };
+		m_Finished.wait(lock, [this]() { return m_PendingCount == 0; });
+	}
+
+	std::vector<std::pair<std::string, bool>> AsyncImageWriter::PopResults()
+	{
+		std::lock_guard lock{ m_Mutex };
+		return std::exchange(m_Results, {});
+	}
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+//Standard includes
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace dae
+{
+	class RenderTarget;
+	class ThreadPool;
+
+	enum class ImageFormat
+	{
+		BMP,
+		PNG,
+		QOI,
+		PPM
+	};
+
+	// Encoders for 32 bit XRGB pixels, stride is in pixels like RenderTarget's
+	class ImageWriter final
+	{
+	public:
+		// by file extension, BMP for unknown ones
+		static ImageFormat GetFormat(const std::string& path);
+
+		static bool Write(const uint32_t* pPixels, int width, int height, int stride, const std::string& path);
+		static bool Write(const RenderTarget& renderTarget, const std::string& path);
+
+		// Quite OK Image format, lossless and several times faster to encode than PNG
+		static std::vector<uint8_t> EncodeQOI(const uint32_t* pPixels, int width, int height, int stride);
+		// binary P6, 8 bit per channel
+		static std::vector<uint8_t> EncodePPM(const uint32_t* pPixels, int width, int height, int stride);
+	};
+
+	// Captures copy the render target into a pooled staging image and return, encoding and disk I/O happen on a
+	// worker thread. The pool holds maxPendingImages images, captures beyond that are dropped instead of waiting.
+	class AsyncImageWriter final
+	{
+	public:
+		explicit AsyncImageWriter(size_t maxPendingImages = 4);
+		// finishes every pending write
+		~AsyncImageWriter();
+
+		AsyncImageWriter(const AsyncImageWriter&) = delete;
+		AsyncImageWriter(AsyncImageWriter&&) noexcept = delete;
+		AsyncImageWriter& operator=(const AsyncImageWriter&) = delete;
+		AsyncImageWriter& operator=(AsyncImageWriter&&) noexcept = delete;
+
+		// false when every staging image is still being written
+		bool Capture(const RenderTarget& renderTarget, const std::string& path);
+		void Flush();
+
+		// (path, written) of every capture finished since the last call
+		std::vector<std::pair<std::string, bool>> PopResults();
+
+	private:
+		struct StagingImage
+		{
+			int width{};
+			int height{};
+			std::vector<uint32_t> pixels{};
+		};
+
+		ThreadPool* m_pThreadPool;
+		const size_t m_MaxPendingImages;
+
+		// guarded by m_Mutex
+		std::vector<StagingImage*> m_FreeImages{};
+		size_t m_ImageCount{};
+		size_t m_PendingCount{};
+		std::vector<std::pair<std::string, bool>> m_Results{};
+		std::mutex m_Mutex{};
+		std::condition_variable m_Finished{};
+	};
+}
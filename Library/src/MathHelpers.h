@@ -2,6 +2,7 @@
 #include <cfloat>
 #include <cmath>
 #include <algorithm>
+#include <type_traits>
 
 namespace dae
 {
@@ -23,43 +24,63 @@ namespace dae
 	constexpr auto TO_RADIANS(PI / 180.0f);
 
 	/* --- HELPER FUNCTIONS --- */
-	inline float Square(float a)
+	constexpr float Square(float a)
 	{
 		return a * a;
 	}
 
-	inline float Lerpf(float a, float b, float factor)
+	constexpr float Lerpf(float a, float b, float factor)
 	{
 		return ((1 - factor) * a) + (factor * b);
 	}
 
-	inline bool AreEqual(float a, float b, float epsilon = FLT_EPSILON)
+	constexpr bool AreEqual(float a, float b, float epsilon = FLT_EPSILON)
 	{
-		return abs(a - b) < epsilon;
+		// std::abs is only constexpr from C++23
+		const float difference{ a - b };
+		return (difference < 0.f ? -difference : difference) < epsilon;
 	}
 
-	inline int Clamp(const int v, int min, int max)
+	// std::sqrt isn't constexpr either, Newton-Raphson when the compiler evaluates it
+	constexpr float Sqrt(float a)
+	{
+		if (std::is_constant_evaluated())
+		{
+			if (a <= 0.f) return 0.f;
+
+			double x{ a }, previous{};
+			for (int iteration{}; iteration < 128 && x != previous; ++iteration)
+			{
+				previous = x;
+				x = 0.5 * (x + a / x);
+			}
+			return float(x);
+		}
+		return std::sqrt(a);
+	}
+
+	constexpr int Clamp(const int v, int min, int max)
 	{
 		if (v < min) return min;
 		if (v > max) return max;
 		return v;
 	}
 
-	inline float Clamp(const float v, float min, float max)
+	constexpr float Clamp(const float v, float min, float max)
 	{
 		if (v < min) return min;
 		if (v > max) return max;
 		return v;
 	}
 
-	inline float Saturate(const float v)
+	constexpr float Saturate(const float v)
 	{
 		if (v < 0.f) return 0.f;
 		if (v > 1.f) return 1.f;
 		return v;
 	}
 
-	inline float Remap(float depthValue, float minValue, float maxValue)
+	constexpr float Remap(float depthValue, float minValue, float maxValue)
 	{
 		return (Clamp(depthValue, minValue, maxValue) - minValue) / (maxValue - minValue);
 	}
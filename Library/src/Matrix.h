@@ -1,65 +1,121 @@
 #pragma once
+#include <cassert>
+#include <cmath>
+#include <span>
+#include <type_traits>
+
+#include "MathHelpers.h"
 #include "Vector3.h"
 #include "Vector4.h"
 
+// SSE is part of every x64 target, define DISABLE_SIMD to fall back to the scalar path
+#if !defined(DISABLE_SIMD) && (defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1))
+#define DAE_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+// the integer SSE2 instructions for pixel work come with every x64 target as well
+#if defined(DAE_USE_SSE) && (defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64))
+#define DAE_USE_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace dae {
 	struct Matrix
 	{
+		// structure of arrays views, one span per component and all of the same size
+		struct SoAInput
+		{
+			std::span<const float> x{};
+			std::span<const float> y{};
+			std::span<const float> z{};
+		};
+
+		struct SoAOutput
+		{
+			std::span<float> x{};
+			std::span<float> y{};
+			std::span<float> z{};
+			std::span<float> w{}; // optional, left empty when w isn't needed
+		};
+
 		Matrix() = default;
-		Matrix(
+		constexpr Matrix(
 			const Vector3& xAxis,
 			const Vector3& yAxis,
 			const Vector3& zAxis,
 			const Vector3& t);
 
-		Matrix(
+		constexpr Matrix(
 			const Vector4& xAxis,
 			const Vector4& yAxis,
 			const Vector4& zAxis,
 			const Vector4& t);
 
-		Matrix(const Matrix& m);
+		constexpr Vector3 TransformVector(const Vector3& v) const;
+		constexpr Vector3 TransformVector(float x, float y, float z) const;
+		constexpr Vector3 TransformPoint(const Vector3& p) const;
+		constexpr Vector3 TransformPoint(float x, float y, float z) const;
+
+		constexpr Vector4 TransformPoint(const Vector4& p) const;
+		constexpr Vector4 TransformPoint(float x, float y, float z, float w) const;
 
-		Vector3 TransformVector(const Vector3& v) const;
-		Vector3 TransformVector(float x, float y, float z) const;
-		Vector3 TransformPoint(const Vector3& p) const;
-		Vector3 TransformPoint(float x, float y, float z) const;
+		// batched versions, output spans must be at least as large as the input and may alias it
+		void TransformVectors(std::span<const Vector3> vectors, std::span<Vector3> vectorsOut) const;
+		void TransformPoints(std::span<const Vector3> points, std::span<Vector3> pointsOut) const;
+		// perspectiveDivide divides x, y and z by w and keeps w for perspective correct interpolation
+		void TransformPoints(std::span<const Vector3> points, std::span<Vector4> pointsOut, bool perspectiveDivide = false) const;
 
-		Vector4 TransformPoint(const Vector4& p) const;
-		Vector4 TransformPoint(float x, float y, float z, float w) const;
+		// structure of arrays versions, 4 elements per SSE instruction
+		void TransformVectors(const SoAInput& vectors, const SoAOutput& vectorsOut) const;
+		void TransformPoints(const SoAInput& points, const SoAOutput& pointsOut, bool perspectiveDivide = false) const;
 
-		const Matrix& Transpose();
-		const Matrix& Inverse();
+		constexpr const Matrix& Transpose();
+		constexpr const Matrix& Inverse();
 
-		Vector3 GetAxisX() const;
-		Vector3 GetAxisY() const;
-		Vector3 GetAxisZ() const;
-		Vector3 GetTranslation() const;
+		constexpr Vector3 GetAxisX() const;
+		constexpr Vector3 GetAxisY() const;
+		constexpr Vector3 GetAxisZ() const;
+		constexpr Vector3 GetTranslation() const;
+		constexpr float GetMaxScale() const;
 
-		static Matrix CreateTranslation(float x, float y, float z);
-		static Matrix CreateTranslation(const Vector3& t);
+		static constexpr Matrix CreateTranslation(float x, float y, float z);
+		static constexpr Matrix CreateTranslation(const Vector3& t);
 		static Matrix CreateRotationX(float pitch);
 		static Matrix CreateRotationY(float yaw);
 		static Matrix CreateRotationZ(float roll);
 		static Matrix CreateRotation(float pitch, float yaw, float roll);
 		static Matrix CreateRotation(const Vector3& r);
-		static Matrix CreateScale(float sx, float sy, float sz);
-		static Matrix CreateScale(const Vector3& s);
-		static Matrix Transpose(const Matrix& m);
-		static Matrix Inverse(const Matrix& m);
+		static constexpr Matrix CreateScale(float sx, float sy, float sz);
+		static constexpr Matrix CreateScale(const Vector3& s);
+		static constexpr Matrix Transpose(const Matrix& m);
+		static constexpr Matrix Inverse(const Matrix& m);
 
-		static Matrix CreateLookAtLH(const Vector3& origin, const Vector3& forward, const Vector3& up);
-		static Matrix CreatePerspectiveFovLH(float fovy, float aspect, float zn, float zf);
+		static constexpr Matrix CreateLookAtLH(const Vector3& origin, const Vector3& forward, const Vector3& up);
+		static constexpr Matrix CreatePerspectiveFovLH(float fovy, float aspect, float zn, float zf);
 
-		Vector4& operator[](int index);
-		Vector4 operator[](int index) const;
-		Matrix operator*(const Matrix& m) const;
-		const Matrix& operator*=(const Matrix& m);
-		bool operator==(const Matrix& m) const;
+		constexpr Vector4& operator[](int index);
+		constexpr Vector4 operator[](int index) const;
+		constexpr Matrix operator*(const Matrix& m) const;
+		constexpr const Matrix& operator*=(const Matrix& m);
+		constexpr bool operator==(const Matrix& m) const;
 
 	private:
 
-		//Row-Major Matrix
+#ifdef DAE_USE_SSE
+		__m128 LoadRow(int index) const;
+
+		// x * row0 + y * row1 + z * row2 + w * row3, same summation order as the scalar path
+		__m128 Combine(__m128 x, __m128 y, __m128 z, __m128 w) const;
+		__m128 Combine(__m128 v) const;
+
+		// the rows are loaded once per batch instead of once per element
+		static __m128 CombineRows(const __m128* pRows, __m128 x, __m128 y, __m128 z, __m128 w);
+		// (x/w, y/w, z/w, w)
+		static __m128 DivideByW(__m128 v);
+#endif
+
+		//Row-Major Matrix, every row is 16 byte aligned
 		Vector4 data[4]
 		{
 			{1,0,0,0}, //xAxis
@@ -73,4 +129,547 @@ namespace dae {
 		// v2x v2y v2z v2w
 		// v3x v3y v3z v3w
 	};
-}
\ No newline at end of file
+
+	constexpr Matrix::Matrix(const Vector3& xAxis, const Vector3& yAxis, const Vector3& zAxis, const Vector3& t) :
+		Matrix({ xAxis, 0 }, { yAxis, 0 }, { zAxis, 0 }, { t, 1 })
+	{
+	}
+
+	constexpr Matrix::Matrix(const Vector4& xAxis, const Vector4& yAxis, const Vector4& zAxis, const Vector4& t)
+	{
+		data[0] = xAxis;
+		data[1] = yAxis;
+		data[2] = zAxis;
+		data[3] = t;
+	}
+
+	// SSE intrinsics can't run in constant evaluation, the compiler takes the scalar path there
+#ifdef DAE_USE_SSE
+	inline __m128 Matrix::LoadRow(int index) const
+	{
+		return _mm_load_ps(&data[index].x);
+	}
+
+	inline __m128 Matrix::Combine(__m128 x, __m128 y, __m128 z, __m128 w) const
+	{
+		const __m128 rows[4]{ LoadRow(0), LoadRow(1), LoadRow(2), LoadRow(3) };
+		return CombineRows(rows, x, y, z, w);
+	}
+
+	inline __m128 Matrix::Combine(__m128 v) const
+	{
+		return Combine(
+			_mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)),
+			_mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)),
+			_mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2)),
+			_mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3)));
+	}
+
+	inline __m128 Matrix::CombineRows(const __m128* pRows, __m128 x, __m128 y, __m128 z, __m128 w)
+	{
+		__m128 result{ _mm_mul_ps(x, pRows[0]) };
+		result = _mm_add_ps(result, _mm_mul_ps(y, pRows[1]));
+		result = _mm_add_ps(result, _mm_mul_ps(z, pRows[2]));
+		return _mm_add_ps(result, _mm_mul_ps(w, pRows[3]));
+	}
+
+	inline __m128 Matrix::DivideByW(__m128 v)
+	{
+		const __m128 divided{ _mm_div_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))) };
+		const __m128 zw{ _mm_shuffle_ps(divided, v, _MM_SHUFFLE(3, 3, 2, 2)) };
+		return _mm_shuffle_ps(divided, zw, _MM_SHUFFLE(2, 0, 1, 0));
+	}
+#endif
+
+	constexpr Vector3 Matrix::TransformVector(const Vector3& v) const
+	{
+		return TransformVector(v.x, v.y, v.z);
+	}
+
+	constexpr Vector3 Matrix::TransformVector(float x, float y, float z) const
+	{
+#ifdef DAE_USE_SSE
+		if (!std::is_constant_evaluated())
+		{
+			Vector4 result;
+			_mm_store_ps(&result.x, Combine(_mm_set1_ps(x), _mm_set1_ps(y), _mm_set1_ps(z), _mm_setzero_ps()));
+			return Vector3{ result.x, result.y, result.z };
+		}
+#endif
+		return Vector3{
+			data[0].x * x + data[1].x * y + data[2].x * z,
+			data[0].y * x + data[1].y * y + data[2].y * z,
+			data[0].z * x + data[1].z * y + data[2].z * z
+		};
+	}
+
+	constexpr Vector3 Matrix::TransformPoint(const Vector3& p) const
+	{
+		return TransformPoint(p.x, p.y, p.z);
+	}
+
+	constexpr Vector3 Matrix::TransformPoint(float x, float y, float z) const
+	{
+#ifdef DAE_USE_SSE
+		if (!std::is_constant_evaluated())
+		{
+			Vector4 result;
+			_mm_store_ps(&result.x, Combine(_mm_set1_ps(x), _mm_set1_ps(y), _mm_set1_ps(z), _mm_set1_ps(1.f)));
+			return Vector3{ result.x, result.y, result.z };
+		}
+#endif
+		return Vector3{
+			data[0].x * x + data[1].x * y + data[2].x * z + data[3].x,
+			data[0].y * x + data[1].y * y + data[2].y * z + data[3].y,
+			data[0].z * x + data[1].z * y + data[2].z * z + data[3].z,
+		};
+	}
+
+	constexpr Vector4 Matrix::TransformPoint(const Vector4& p) const
+	{
+#ifdef DAE_USE_SSE
+		if (!std::is_constant_evaluated())
+		{
+			Vector4 result;
+			_mm_store_ps(&result.x, Combine(_mm_load_ps(&p.x)));
+			return result;
+		}
+#endif
+		return TransformPoint(p.x, p.y, p.z, p.w);
+	}
+
+	constexpr Vector4 Matrix::TransformPoint(float x, float y, float z, float w) const
+	{
+#ifdef DAE_USE_SSE
+		if (!std::is_constant_evaluated())
+		{
+			Vector4 result;
+			_mm_store_ps(&result.x, Combine(_mm_set1_ps(x), _mm_set1_ps(y), _mm_set1_ps(z), _mm_set1_ps(w)));
+			return result;
+		}
+#endif
+		// row 3 is scaled by w, this used to add it unscaled (every caller passed w = 1)
+		return Vector4{
+			data[0].x * x + data[1].x * y + data[2].x * z + data[3].x * w,
+			data[0].y * x + data[1].y * y + data[2].y * z + data[3].y * w,
+			data[0].z * x + data[1].z * y + data[2].z * z + data[3].z * w,
+			data[0].w * x + data[1].w * y + data[2].w * z + data[3].w * w
+		};
+	}
+
+	constexpr const Matrix& Matrix::Transpose()
+	{
+#ifdef DAE_USE_SSE
+		if (!std::is_constant_evaluated())
+		{
+			__m128 row0{ LoadRow(0) }, row1{ LoadRow(1) }, row2{ LoadRow(2) }, row3{ LoadRow(3) };
+			_MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+			_mm_store_ps(&data[0].x, row0);
+			_mm_store_ps(&data[1].x, row1);
+			_mm_store_ps(&data[2].x, row2);
+			_mm_store_ps(&data[3].x, row3);
+			return *this;
+		}
+#endif
+		Matrix result{};
+		for (int r{ 0 }; r < 4; ++r)
+		{
+			for (int c{ 0 }; c < 4; ++c)
+			{
+				result[r][c] = data[c][r];
+			}
+		}
+
+		data[0] = result[0];
+		data[1] = result[1];
+		data[2] = result[2];
+		data[3] = result[3];
+
+		return *this;
+	}
+
+	constexpr Matrix Matrix::Transpose(const Matrix& m)
+	{
+		Matrix out{ m };
+		out.Transpose();
+
+		return out;
+	}
+
+	constexpr Matrix Matrix::operator*(const Matrix& m) const
+	{
+		Matrix result{ *this };
+		result *= m;
+
+		return result;
+	}
+
+	constexpr const Matrix& Matrix::operator*=(const Matrix& m)
+	{
+#ifdef DAE_USE_SSE
+		if (!std::is_constant_evaluated())
+		{
+			// every row of the result is the row of this combined with the rows of m
+			const __m128 result0{ m.Combine(LoadRow(0)) };
+			const __m128 result1{ m.Combine(LoadRow(1)) };
+			const __m128 result2{ m.Combine(LoadRow(2)) };
+			const __m128 result3{ m.Combine(LoadRow(3)) };
+			_mm_store_ps(&data[0].x, result0);
+			_mm_store_ps(&data[1].x, result1);
+			_mm_store_ps(&data[2].x, result2);
+			_mm_store_ps(&data[3].x, result3);
+			return *this;
+		}
+#endif
+		Matrix copy{ *this };
+		Matrix m_transposed = Transpose(m);
+
+		for (int r{ 0 }; r < 4; ++r)
+		{
+			for (int c{ 0 }; c < 4; ++c)
+			{
+				data[r][c] = Vector4::Dot(copy[r], m_transposed[c]);
+			}
+		}
+
+		return *this;
+	}
+
+	inline void Matrix::TransformVectors(std::span<const Vector3> vectors, std::span<Vector3> vectorsOut) const
+	{
+		assert(vectorsOut.size() >= vectors.size());
+#ifdef DAE_USE_SSE
+		const __m128 rows[4]{ LoadRow(0), LoadRow(1), LoadRow(2), _mm_setzero_ps() };
+		const __m128 zero{ _mm_setzero_ps() };
+		Vector4 result;
+		for (size_t idx{}; idx < vectors.size(); ++idx)
+		{
+			const Vector3& v{ vectors[idx] };
+			_mm_store_ps(&result.x, CombineRows(rows, _mm_set1_ps(v.x), _mm_set1_ps(v.y), _mm_set1_ps(v.z), zero));
+			vectorsOut[idx] = Vector3{ result.x, result.y, result.z };
+		}
+#else
+		for (size_t idx{}; idx < vectors.size(); ++idx)
+		{
+			vectorsOut[idx] = TransformVector(vectors[idx]);
+		}
+#endif
+	}
+
+	inline void Matrix::TransformPoints(std::span<const Vector3> points, std::span<Vector3> pointsOut) const
+	{
+		assert(pointsOut.size() >= points.size());
+#ifdef DAE_USE_SSE
+		const __m128 rows[4]{ LoadRow(0), LoadRow(1), LoadRow(2), LoadRow(3) };
+		const __m128 one{ _mm_set1_ps(1.f) };
+		Vector4 result;
+		for (size_t idx{}; idx < points.size(); ++idx)
+		{
+			const Vector3& p{ points[idx] };
+			_mm_store_ps(&result.x, CombineRows(rows, _mm_set1_ps(p.x), _mm_set1_ps(p.y), _mm_set1_ps(p.z), one));
+			pointsOut[idx] = Vector3{ result.x, result.y, result.z };
+		}
+#else
+		for (size_t idx{}; idx < points.size(); ++idx)
+		{
+			pointsOut[idx] = TransformPoint(points[idx]);
+		}
+#endif
+	}
+
+	inline void Matrix::TransformPoints(std::span<const Vector3> points, std::span<Vector4> pointsOut, bool perspectiveDivide) const
+	{
+		assert(pointsOut.size() >= points.size());
+#ifdef DAE_USE_SSE
+		const __m128 rows[4]{ LoadRow(0), LoadRow(1), LoadRow(2), LoadRow(3) };
+		const __m128 one{ _mm_set1_ps(1.f) };
+		for (size_t idx{}; idx < points.size(); ++idx)
+		{
+			const Vector3& p{ points[idx] };
+			const __m128 result{ CombineRows(rows, _mm_set1_ps(p.x), _mm_set1_ps(p.y), _mm_set1_ps(p.z), one) };
+			_mm_store_ps(&pointsOut[idx].x, perspectiveDivide ? DivideByW(result) : result);
+		}
+#else
+		for (size_t idx{}; idx < points.size(); ++idx)
+		{
+			const Vector3& p{ points[idx] };
+			Vector4 result{ TransformPoint(p.x, p.y, p.z, 1.f) };
+			if (perspectiveDivide)
+			{
+				result.x /= result.w;
+				result.y /= result.w;
+				result.z /= result.w;
+			}
+			pointsOut[idx] = result;
+		}
+#endif
+	}
+
+	inline void Matrix::TransformVectors(const SoAInput& vectors, const SoAOutput& vectorsOut) const
+	{
+		const size_t count{ vectors.x.size() };
+		assert(vectors.y.size() == count && vectors.z.size() == count);
+		assert(vectorsOut.x.size() >= count && vectorsOut.y.size() >= count && vectorsOut.z.size() >= count);
+
+		size_t idx{};
+#ifdef DAE_USE_SSE
+		// m[r][c] broadcast, every lane is a different vector
+		__m128 m[3][3]{};
+		for (int r{}; r < 3; ++r)
+		{
+			for (int c{}; c < 3; ++c) m[r][c] = _mm_set1_ps(data[r][c]);
+		}
+
+		for (; idx + 4 <= count; idx += 4)
+		{
+			const __m128 x{ _mm_loadu_ps(&vectors.x[idx]) };
+			const __m128 y{ _mm_loadu_ps(&vectors.y[idx]) };
+			const __m128 z{ _mm_loadu_ps(&vectors.z[idx]) };
+
+			float* pOut[3]{ &vectorsOut.x[idx], &vectorsOut.y[idx], &vectorsOut.z[idx] };
+			for (int c{}; c < 3; ++c)
+			{
+				const __m128 result{ _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m[0][c]), _mm_mul_ps(y, m[1][c])), _mm_mul_ps(z, m[2][c])) };
+				_mm_storeu_ps(pOut[c], result);
+			}
+		}
+#endif
+		for (; idx < count; ++idx)
+		{
+			const Vector3 result{ TransformVector(vectors.x[idx], vectors.y[idx], vectors.z[idx]) };
+			vectorsOut.x[idx] = result.x;
+			vectorsOut.y[idx] = result.y;
+			vectorsOut.z[idx] = result.z;
+		}
+	}
+
+	inline void Matrix::TransformPoints(const SoAInput& points, const SoAOutput& pointsOut, bool perspectiveDivide) const
+	{
+		const size_t count{ points.x.size() };
+		const bool writeW{ !pointsOut.w.empty() };
+		assert(points.y.size() == count && points.z.size() == count);
+		assert(pointsOut.x.size() >= count && pointsOut.y.size() >= count && pointsOut.z.size() >= count);
+		assert(!writeW || pointsOut.w.size() >= count);
+
+		size_t idx{};
+#ifdef DAE_USE_SSE
+		__m128 m[4][4]{};
+		for (int r{}; r < 4; ++r)
+		{
+			for (int c{}; c < 4; ++c) m[r][c] = _mm_set1_ps(data[r][c]);
+		}
+
+		for (; idx + 4 <= count; idx += 4)
+		{
+			const __m128 x{ _mm_loadu_ps(&points.x[idx]) };
+			const __m128 y{ _mm_loadu_ps(&points.y[idx]) };
+			const __m128 z{ _mm_loadu_ps(&points.z[idx]) };
+
+			__m128 result[4]{};
+			for (int c{}; c < 4; ++c)
+			{
+				result[c] = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m[0][c]), _mm_mul_ps(y, m[1][c])), _mm_mul_ps(z, m[2][c])), m[3][c]);
+			}
+
+			if (perspectiveDivide)
+			{
+				const __m128 inverseW{ _mm_div_ps(_mm_set1_ps(1.f), result[3]) };
+				for (int c{}; c < 3; ++c) result[c] = _mm_mul_ps(result[c], inverseW);
+			}
+
+			_mm_storeu_ps(&pointsOut.x[idx], result[0]);
+			_mm_storeu_ps(&pointsOut.y[idx], result[1]);
+			_mm_storeu_ps(&pointsOut.z[idx], result[2]);
+			if (writeW) _mm_storeu_ps(&pointsOut.w[idx], result[3]);
+		}
+#endif
+		for (; idx < count; ++idx)
+		{
+			Vector4 result{ TransformPoint(points.x[idx], points.y[idx], points.z[idx], 1.f) };
+			if (perspectiveDivide)
+			{
+				result.x /= result.w;
+				result.y /= result.w;
+				result.z /= result.w;
+			}
+
+			pointsOut.x[idx] = result.x;
+			pointsOut.y[idx] = result.y;
+			pointsOut.z[idx] = result.z;
+			if (writeW) pointsOut.w[idx] = result.w;
+		}
+	}
+
+	constexpr const Matrix& Matrix::Inverse()
+	{
+		//Optimized Inverse as explained in FGED1 - used widely in other libraries too.
+		const Vector3& a = data[0];
+		const Vector3& b = data[1];
+		const Vector3& c = data[2];
+		const Vector3& d = data[3];
+
+		const float x = data[0][3];
+		const float y = data[1][3];
+		const float z = data[2][3];
+		const float w = data[3][3];
+
+		Vector3 s = Vector3::Cross(a, b);
+		Vector3 t = Vector3::Cross(c, d);
+		Vector3 u = a * y - b * x;
+		Vector3 v = c * w - d * z;
+
+		float det = Vector3::Dot(s, v) + Vector3::Dot(t, u);
+		assert((!AreEqual(det, 0.f)) && "ERROR: determinant is 0, there is no INVERSE!");
+		float invDet = 1.f / det;
+
+		s *= invDet; t *= invDet; u *= invDet; v *= invDet;
+
+		Vector3 r0 = Vector3::Cross(b, v) + t * y;
+		Vector3 r1 = Vector3::Cross(v, a) - t * x;
+		Vector3 r2 = Vector3::Cross(d, u) + s * w;
+		Vector3 r3 = Vector3::Cross(u, c) - s * z;
+
+		data[0] = Vector4{ r0.x, r1.x, r2.x, r3.x };
+		data[1] = Vector4{ r0.y, r1.y, r2.y, r3.y };
+		data[2] = Vector4{ r0.z, r1.z, r2.z, r3.z };
+		data[3] = { { -Vector3::Dot(b, t)},{Vector3::Dot(a, t)},{-Vector3::Dot(d, s)},{Vector3::Dot(c, s)} };
+
+		return *this;
+	}
+
+	constexpr Matrix Matrix::Inverse(const Matrix& m)
+	{
+		Matrix out{ m };
+		out.Inverse();
+
+		return out;
+	}
+
+	constexpr Matrix Matrix::CreateLookAtLH(const Vector3& origin, const Vector3& forward, const Vector3& up)
+	{
+		Vector3 z{forward.Normalized() };
+		Vector3 x{ Vector3::Cross(up, z).Normalized() };
+		Vector3 y{ Vector3::Cross(z,x) };
+
+		return Matrix{ {x.x, y.x, z.x, 0.f},
+					   {x.y, y.y, z.y, 0.f},
+					   {x.z, y.z, z.z, 0.f},
+					   {Vector3::Dot(-x, origin), Vector3::Dot(-y, origin), Vector3::Dot(-z,origin), 1.f} };
+	}
+
+	constexpr Matrix Matrix::CreatePerspectiveFovLH(float fov, float aspect, float zn, float zf)
+	{
+		return Matrix{ {1/(aspect*fov), 0.f, 0.f, 0.f}, 
+					   {0.f, 1/fov, 0.f,0.f}, 
+					   { 0.f, 0.f , zf/(zf-zn), 1.f}, 
+					   {0.f, 0.f, -(zf*zn)/(zf-zn), 0.f} };
+	}
+
+	constexpr Vector3 Matrix::GetAxisX() const
+	{
+		return data[0];
+	}
+
+	constexpr Vector3 Matrix::GetAxisY() const
+	{
+		return data[1];
+	}
+
+	constexpr Vector3 Matrix::GetAxisZ() const
+	{
+		return data[2];
+	}
+
+	constexpr Vector3 Matrix::GetTranslation() const
+	{
+		return data[3];
+	}
+
+	constexpr float Matrix::GetMaxScale() const
+	{
+		return std::max({ GetAxisX().Magnitude(), GetAxisY().Magnitude(), GetAxisZ().Magnitude() });
+	}
+
+	constexpr Matrix Matrix::CreateTranslation(float x, float y, float z)
+	{
+		return CreateTranslation({ x, y, z });
+	}
+
+	constexpr Matrix Matrix::CreateTranslation(const Vector3& t)
+	{
+		return { Vector3::UnitX, Vector3::UnitY, Vector3::UnitZ, t };
+	}
+
+	inline Matrix Matrix::CreateRotationX(float pitch)
+	{
+		return {
+			{1, 0, 0, 0},
+			{0, cosf(pitch), -sinf(pitch), 0},
+			{0, sinf(pitch), cosf(pitch), 0},
+			{0, 0, 0, 1}
+		};
+	}
+
+	inline Matrix Matrix::CreateRotationY(float yaw)
+	{
+		return {
+			{cosf(yaw), 0, -sinf(yaw), 0},
+			{0, 1, 0, 0},
+			{sinf(yaw), 0, cosf(yaw), 0},
+			{0, 0, 0, 1}
+		};
+	}
+
+	inline Matrix Matrix::CreateRotationZ(float roll)
+	{
+		return {
+			{cosf(roll), sinf(roll), 0, 0},
+			{-sinf(roll), cosf(roll), 0, 0},
+			{0, 0, 1, 0},
+			{0, 0, 0, 1}
+		};
+	}
+
+	inline Matrix Matrix::CreateRotation(float pitch, float yaw, float roll)
+	{
+		return CreateRotation({ pitch, yaw, roll });
+	}
+
+	inline Matrix Matrix::CreateRotation(const Vector3& r)
+	{
+		return CreateRotationX(r[0]) * CreateRotationY(r[1]) * CreateRotationZ(r[2]);
+	}
+
+	constexpr Matrix Matrix::CreateScale(float sx, float sy, float sz)
+	{
+		return { {sx, 0, 0}, {0, sy, 0}, {0, 0, sz}, Vector3::Zero };
+	}
+
+	constexpr Matrix Matrix::CreateScale(const Vector3& s)
+	{
+		return CreateScale(s[0], s[1], s[2]);
+	}
+
+#pragma region Operator Overloads
+	constexpr Vector4& Matrix::operator[](int index)
+	{
+		assert(index <= 3 && index >= 0);
+		return data[index];
+	}
+
+	constexpr Vector4 Matrix::operator[](int index) const
+	{
+		assert(index <= 3 && index >= 0);
+		return data[index];
+	}
+
+	constexpr bool Matrix::operator==(const Matrix& m) const
+	{
+		return data[0] == m.data[0]
+		    && data[1] == m.data[1]
+			&& data[2] == m.data[2]
+			&& data[3] == m.data[3];
+	}
+
+#pragma endregion
+}
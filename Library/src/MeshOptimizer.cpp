@@ -0,0 +1,591 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <numeric>
+#include <unordered_map>
+
+namespace dae
+{
+	namespace
+	{
+		struct VertexKey
+		{
+			Vector3 position{};
+			Vector2 uv{};
+			Vector3 normal{};
+			ColorRGB color{};
+
+			bool operator==(const VertexKey& other) const
+			{
+				// exact compare, welding must not change the look of the mesh
+				return std::memcmp(this, &other, sizeof(VertexKey)) == 0;
+			}
+		};
+
+		struct VertexKeyHash
+		{
+			size_t operator()(const VertexKey& key) const
+			{
+				// FNV-1a over the raw bytes
+				const uint8_t* pBytes{ reinterpret_cast<const uint8_t*>(&key) };
+				size_t hash{ 14695981039346656037ull };
+				for (size_t idx{}; idx < sizeof(VertexKey); ++idx)
+				{
+					hash ^= pBytes[idx];
+					hash *= 1099511628211ull;
+				}
+				return hash;
+			}
+		};
+
+		// FIFO post-transform cache, returns the amount of misses for one triangle
+		class CacheSimulator final
+		{
+		public:
+			CacheSimulator(size_t vertexCount, int cacheSize) :
+				m_Timestamps(vertexCount, 0),
+				m_CacheSize{ uint32_t(cacheSize) }
+			{
+			}
+
+			void Reset()
+			{
+				// pushing the clock past the cache size invalidates every entry
+				m_Time += m_CacheSize + 1;
+			}
+
+			int Triangle(const uint32_t* pIndices)
+			{
+				int misses{};
+				for (int idx{}; idx < 3; ++idx)
+				{
+					const uint32_t vertex{ pIndices[idx] };
+					if (m_Time - m_Timestamps[vertex] > m_CacheSize)
+					{
+						m_Timestamps[vertex] = m_Time++;
+						++misses;
+					}
+				}
+				return misses;
+			}
+
+		private:
+			std::vector<uint32_t> m_Timestamps;
+			uint32_t m_CacheSize;
+			uint32_t m_Time{ m_CacheSize + 1 };
+		};
+
+		void RasterizeOverdraw(const Vector2& p0, const Vector2& p1, const Vector2& p2, float z0, float z1, float z2,
+			std::vector<float>& depthBuffer, int gridSize, size_t& shaded)
+		{
+			const float area{ Vector2::Cross(p1 - p0, p2 - p0) };
+			if (AreEqual(area, 0.f)) return;
+
+			const int minX{ Clamp(int(std::min({ p0.x, p1.x, p2.x })), 0, gridSize - 1) };
+			const int minY{ Clamp(int(std::min({ p0.y, p1.y, p2.y })), 0, gridSize - 1) };
+			const int maxX{ Clamp(int(std::max({ p0.x, p1.x, p2.x })) + 1, 0, gridSize - 1) };
+			const int maxY{ Clamp(int(std::max({ p0.y, p1.y, p2.y })) + 1, 0, gridSize - 1) };
+
+			for (int py{ minY }; py <= maxY; ++py)
+			{
+				for (int px{ minX }; px <= maxX; ++px)
+				{
+					const Vector2 pixel{ px + 0.5f, py + 0.5f };
+					const float w0{ Vector2::Cross(p2 - p1, pixel - p1) / area };
+					const float w1{ Vector2::Cross(p0 - p2, pixel - p2) / area };
+					const float w2{ Vector2::Cross(p1 - p0, pixel - p0) / area };
+					if (w0 < 0.f || w1 < 0.f || w2 < 0.f) continue;
+
+					// orthographic views, depth interpolates linearly
+					const float depth{ w0 * z0 + w1 * z1 + w2 * z2 };
+					float& storedDepth{ depthBuffer[px + py * gridSize] };
+					if (depth < storedDepth)
+					{
+						storedDepth = depth;
+						++shaded;
+					}
+				}
+			}
+		}
+	}
+
+	MeshOptimizationStats MeshOptimizer::OptimizeMesh(Mesh& mesh)
+	{
+		assert(mesh.primitiveTopology == PrimitiveTopology::TriangleList && "MeshOptimizer only supports triangle lists");
+
+		MeshOptimizationStats stats{};
+		stats.verticesBefore = mesh.vertices.size();
+		stats.acmrBefore = CalculateACMR(mesh.indices, mesh.vertices.size());
+		stats.overdrawBefore = CalculateOverdraw(mesh.vertices, mesh.indices);
+
+		std::vector<uint32_t> clusters{};
+		WeldVertices(mesh.vertices, mesh.indices);
+		OptimizeVertexCache(mesh.indices, mesh.vertices.size(), &clusters);
+		OptimizeOverdraw(mesh.indices, mesh.vertices, clusters);
+		OptimizeVertexFetch(mesh.vertices, mesh.indices);
+
+		stats.verticesAfter = mesh.vertices.size();
+		stats.acmrAfter = CalculateACMR(mesh.indices, mesh.vertices.size());
+		stats.overdrawAfter = CalculateOverdraw(mesh.vertices, mesh.indices);
+
+		return stats;
+	}
+
+	void MeshOptimizer::WeldVertices(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+	{
+		std::unordered_map<VertexKey, uint32_t, VertexKeyHash> uniqueVertices{};
+		uniqueVertices.reserve(vertices.size());
+
+		std::vector<Vertex> welded{};
+		std::vector<uint32_t> remap(vertices.size());
+
+		for (size_t idx{}; idx < vertices.size(); ++idx)
+		{
+			const Vertex& vertex{ vertices[idx] };
+			VertexKey key{};
+			key.position = vertex.position;
+			key.uv = vertex.uv;
+			key.normal = vertex.normal;
+			key.color = vertex.color;
+
+			const auto result{ uniqueVertices.try_emplace(key, uint32_t(welded.size())) };
+			if (result.second)
+			{
+				welded.push_back(vertex);
+			}
+			else
+			{
+				// tangents are accumulated per face by the parser, average them over the welded corners
+				welded[result.first->second].tangent += vertex.tangent;
+			}
+			remap[idx] = result.first->second;
+		}
+
+		for (Vertex& vertex : welded)
+		{
+			if (vertex.tangent.SqrMagnitude() > 0.f)
+			{
+				vertex.tangent = Vector3::Reject(vertex.tangent, vertex.normal).Normalized();
+			}
+		}
+
+		for (uint32_t& index : indices)
+		{
+			index = remap[index];
+		}
+		vertices = std::move(welded);
+	}
+
+	void MeshOptimizer::OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, std::vector<uint32_t>* pClusters, int cacheSize)
+	{
+		const size_t triangleCount{ indices.size() / 3 };
+		if (triangleCount == 0) return;
+
+		// vertex -> triangle adjacency
+		std::vector<uint32_t> liveTriangles(vertexCount, 0);
+		for (uint32_t index : indices) ++liveTriangles[index];
+
+		std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+		for (size_t idx{}; idx < vertexCount; ++idx) adjacencyOffsets[idx + 1] = adjacencyOffsets[idx] + liveTriangles[idx];
+
+		std::vector<uint32_t> adjacency(indices.size());
+		std::vector<uint32_t> fill{ adjacencyOffsets.begin(), adjacencyOffsets.end() - 1 };
+		for (size_t triangleIdx{}; triangleIdx < triangleCount; ++triangleIdx)
+		{
+			for (int corner{}; corner < 3; ++corner)
+			{
+				adjacency[fill[indices[triangleIdx * 3 + corner]]++] = uint32_t(triangleIdx);
+			}
+		}
+
+		std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+		std::vector<bool> emitted(triangleCount, false);
+		std::vector<uint32_t> deadEnd{};
+		std::vector<uint32_t> candidates{};
+
+		std::vector<uint32_t> result{};
+		result.reserve(indices.size());
+		if (pClusters) pClusters->clear();
+
+		uint32_t time{ uint32_t(cacheSize) + 1 };
+		size_t cursor{ 1 };
+		int fanningVertex{ 0 };
+
+		// skips to a vertex that still has triangles, the cache is considered cold after this
+		const auto skipDeadEnd{ [&]() -> int
+			{
+				while (!deadEnd.empty())
+				{
+					const uint32_t vertex{ deadEnd.back() };
+					deadEnd.pop_back();
+					if (liveTriangles[vertex] > 0) return int(vertex);
+				}
+				while (cursor < vertexCount)
+				{
+					if (liveTriangles[cursor] > 0) return int(cursor++);
+					++cursor;
+				}
+				return -1;
+			} };
+
+		bool startCluster{ true };
+		while (fanningVertex >= 0)
+		{
+			candidates.clear();
+
+			for (uint32_t adjIdx{ adjacencyOffsets[fanningVertex] }; adjIdx < adjacencyOffsets[fanningVertex + 1]; ++adjIdx)
+			{
+				const uint32_t triangle{ adjacency[adjIdx] };
+				if (emitted[triangle]) continue;
+
+				if (startCluster && pClusters)
+				{
+					pClusters->push_back(uint32_t(result.size() / 3));
+				}
+				startCluster = false;
+
+				for (int corner{}; corner < 3; ++corner)
+				{
+					const uint32_t vertex{ indices[triangle * 3 + corner] };
+					result.push_back(vertex);
+					deadEnd.push_back(vertex);
+					candidates.push_back(vertex);
+					--liveTriangles[vertex];
+
+					if (time - cacheTimestamps[vertex] > uint32_t(cacheSize))
+					{
+						cacheTimestamps[vertex] = time++;
+					}
+				}
+				emitted[triangle] = true;
+			}
+
+			// pick the candidate that stays in cache the longest while still having work left
+			int bestVertex{ -1 };
+			int bestPriority{ -1 };
+			for (uint32_t vertex : candidates)
+			{
+				if (liveTriangles[vertex] == 0) continue;
+
+				int priority{ 0 };
+				if (time - cacheTimestamps[vertex] + 2 * liveTriangles[vertex] <= uint32_t(cacheSize))
+				{
+					priority = int(time - cacheTimestamps[vertex]);
+				}
+				if (priority > bestPriority)
+				{
+					bestPriority = priority;
+					bestVertex = int(vertex);
+				}
+			}
+
+			if (bestVertex == -1)
+			{
+				bestVertex = skipDeadEnd();
+				startCluster = true;
+			}
+			fanningVertex = bestVertex;
+		}
+
+		assert(result.size() == indices.size());
+		indices = std::move(result);
+	}
+
+	void MeshOptimizer::OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& clusters, float threshold, int cacheSize)
+	{
+		const size_t triangleCount{ indices.size() / 3 };
+		if (triangleCount == 0 || clusters.empty()) return;
+
+		// split the hard clusters further where it does not hurt the cache efficiency of that cluster
+		std::vector<uint32_t> softClusters{};
+		CacheSimulator cache{ vertices.size(), cacheSize };
+		for (size_t clusterIdx{}; clusterIdx < clusters.size(); ++clusterIdx)
+		{
+			const uint32_t start{ clusters[clusterIdx] };
+			const uint32_t end{ clusterIdx + 1 < clusters.size() ? clusters[clusterIdx + 1] : uint32_t(triangleCount) };
+
+			cache.Reset();
+			int clusterMisses{};
+			for (uint32_t triangle{ start }; triangle < end; ++triangle) clusterMisses += cache.Triangle(&indices[triangle * 3]);
+			const float clusterACMR{ float(clusterMisses) / float(end - start) };
+
+			cache.Reset();
+			softClusters.push_back(start);
+			int softMisses{};
+			uint32_t softStart{ start };
+			for (uint32_t triangle{ start }; triangle < end; ++triangle)
+			{
+				softMisses += cache.Triangle(&indices[triangle * 3]);
+				if (triangle + 1 < end && float(softMisses) <= float(triangle + 1 - softStart) * clusterACMR * threshold)
+				{
+					softClusters.push_back(triangle + 1);
+					softStart = triangle + 1;
+					softMisses = 0;
+					cache.Reset();
+				}
+			}
+		}
+
+		// mesh centroid
+		Vector3 meshCentroid{};
+		for (const Vertex& vertex : vertices) meshCentroid += vertex.position;
+		if (!vertices.empty()) meshCentroid /= float(vertices.size());
+
+		std::vector<float> sortKeys(softClusters.size());
+		for (size_t clusterIdx{}; clusterIdx < softClusters.size(); ++clusterIdx)
+		{
+			const uint32_t start{ softClusters[clusterIdx] };
+			const uint32_t end{ clusterIdx + 1 < softClusters.size() ? softClusters[clusterIdx + 1] : uint32_t(triangleCount) };
+
+			Vector3 centroid{};
+			Vector3 normal{};
+			float totalArea{};
+			for (uint32_t triangle{ start }; triangle < end; ++triangle)
+			{
+				const Vertex& v0{ vertices[indices[triangle * 3 + 0]] };
+				const Vertex& v1{ vertices[indices[triangle * 3 + 1]] };
+				const Vertex& v2{ vertices[indices[triangle * 3 + 2]] };
+
+				const float area{ Vector3::Cross(v1.position - v0.position, v2.position - v0.position).Magnitude() * 0.5f };
+				centroid += (v0.position + v1.position + v2.position) * (area / 3.f);
+				normal += (v0.normal + v1.normal + v2.normal) * area;
+				totalArea += area;
+			}
+
+			if (totalArea > 0.f) centroid /= totalArea;
+			if (normal.SqrMagnitude() > 0.f) normal.Normalize();
+
+			// clusters far out along their own normal occlude the rest from most viewpoints
+			sortKeys[clusterIdx] = Vector3::Dot(centroid - meshCentroid, normal);
+		}
+
+		std::vector<size_t> order(softClusters.size());
+		std::iota(order.begin(), order.end(), size_t{});
+		std::stable_sort(order.begin(), order.end(), [&sortKeys](size_t a, size_t b) { return sortKeys[a] > sortKeys[b]; });
+
+		std::vector<uint32_t> result{};
+		result.reserve(indices.size());
+		for (size_t clusterIdx : order)
+		{
+			const uint32_t start{ softClusters[clusterIdx] };
+			const uint32_t end{ clusterIdx + 1 < softClusters.size() ? softClusters[clusterIdx + 1] : uint32_t(triangleCount) };
+			result.insert(result.end(), indices.begin() + start * 3, indices.begin() + end * 3);
+		}
+
+		indices = std::move(result);
+	}
+
+	void MeshOptimizer::OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+	{
+		constexpr uint32_t unused{ UINT32_MAX };
+		std::vector<uint32_t> remap(vertices.size(), unused);
+		std::vector<Vertex> result{};
+		result.reserve(vertices.size());
+
+		for (uint32_t& index : indices)
+		{
+			if (remap[index] == unused)
+			{
+				remap[index] = uint32_t(result.size());
+				result.push_back(vertices[index]);
+			}
+			index = remap[index];
+		}
+
+		// unreferenced vertices are dropped
+		vertices = std::move(result);
+	}
+
+	void MeshOptimizer::BuildMeshlets(Mesh& mesh, uint32_t maxVertices, uint32_t maxTriangles)
+	{
+		assert(mesh.primitiveTopology == PrimitiveTopology::TriangleList && "Meshlets are only supported for triangle lists");
+		assert(maxVertices < 256 && "Meshlet triangles use 8 bit local indices");
+
+		mesh.meshlets.clear();
+		mesh.meshletVertices.clear();
+		mesh.meshletTriangles.clear();
+
+		constexpr uint8_t unused{ 0xff };
+		std::vector<uint8_t> localIndices(mesh.vertices.size(), unused);
+		Meshlet meshlet{};
+
+		const auto computeBounds{ [&mesh](Meshlet& meshlet)
+			{
+				const uint32_t* pVertices{ &mesh.meshletVertices[meshlet.vertexOffset] };
+
+				Vector3 minBounds{ mesh.vertices[pVertices[0]].position };
+				Vector3 maxBounds{ minBounds };
+				for (uint32_t idx{}; idx < meshlet.vertexCount; ++idx)
+				{
+					const Vector3& position{ mesh.vertices[pVertices[idx]].position };
+					for (int axis{}; axis < 3; ++axis)
+					{
+						minBounds[axis] = std::min(minBounds[axis], position[axis]);
+						maxBounds[axis] = std::max(maxBounds[axis], position[axis]);
+					}
+				}
+
+				meshlet.center = (minBounds + maxBounds) * 0.5f;
+				meshlet.radius = 0.f;
+				for (uint32_t idx{}; idx < meshlet.vertexCount; ++idx)
+				{
+					meshlet.radius = std::max(meshlet.radius, (mesh.vertices[pVertices[idx]].position - meshlet.center).Magnitude());
+				}
+
+				// normal cone around the face normals, same winding rule as the rasterizer
+				std::vector<Vector3> faceNormals{};
+				faceNormals.reserve(meshlet.triangleCount);
+				Vector3 axis{};
+				for (uint32_t triangle{}; triangle < meshlet.triangleCount; ++triangle)
+				{
+					const uint8_t* pTriangle{ &mesh.meshletTriangles[(meshlet.triangleOffset + triangle) * 3] };
+					const Vector3& p0{ mesh.vertices[pVertices[pTriangle[0]]].position };
+					const Vector3& p1{ mesh.vertices[pVertices[pTriangle[1]]].position };
+					const Vector3& p2{ mesh.vertices[pVertices[pTriangle[2]]].position };
+
+					Vector3 normal{ Vector3::Cross(p1 - p0, p2 - p0) };
+					if (normal.SqrMagnitude() <= FLT_EPSILON * FLT_EPSILON) continue;
+					normal.Normalize();
+					faceNormals.push_back(normal);
+					axis += normal;
+				}
+
+				meshlet.coneAxis = {};
+				meshlet.coneCutoff = 1.f;
+				if (faceNormals.empty() || axis.SqrMagnitude() <= FLT_EPSILON) return;
+				axis.Normalize();
+
+				float minDot{ 1.f };
+				for (const Vector3& normal : faceNormals) minDot = std::min(minDot, Vector3::Dot(axis, normal));
+
+				// wider than ~85 degrees can never be culled reliably, keep the cutoff at 1
+				meshlet.coneAxis = axis;
+				if (minDot > 0.1f) meshlet.coneCutoff = sqrtf(1.f - minDot * minDot);
+			} };
+
+		const auto flush{ [&]()
+			{
+				if (meshlet.triangleCount == 0) return;
+
+				for (uint32_t idx{}; idx < meshlet.vertexCount; ++idx)
+				{
+					localIndices[mesh.meshletVertices[meshlet.vertexOffset + idx]] = unused;
+				}
+				computeBounds(meshlet);
+				mesh.meshlets.push_back(meshlet);
+
+				meshlet = Meshlet{};
+				meshlet.vertexOffset = uint32_t(mesh.meshletVertices.size());
+				meshlet.triangleOffset = uint32_t(mesh.meshletTriangles.size() / 3);
+			} };
+
+		for (size_t idx{}; idx + 2 < mesh.indices.size(); idx += 3)
+		{
+			uint32_t newVertices{};
+			for (int corner{}; corner < 3; ++corner)
+			{
+				if (localIndices[mesh.indices[idx + corner]] == unused) ++newVertices;
+			}
+
+			if (meshlet.vertexCount + newVertices > maxVertices || meshlet.triangleCount + 1 > maxTriangles)
+			{
+				flush();
+			}
+
+			for (int corner{}; corner < 3; ++corner)
+			{
+				const uint32_t vertex{ mesh.indices[idx + corner] };
+				if (localIndices[vertex] == unused)
+				{
+					localIndices[vertex] = uint8_t(meshlet.vertexCount++);
+					mesh.meshletVertices.push_back(vertex);
+				}
+				mesh.meshletTriangles.push_back(localIndices[vertex]);
+			}
+			++meshlet.triangleCount;
+		}
+		flush();
+	}
+
+	float MeshOptimizer::CalculateACMR(const std::vector<uint32_t>& indices, size_t vertexCount, int cacheSize)
+	{
+		const size_t triangleCount{ indices.size() / 3 };
+		if (triangleCount == 0) return 0.f;
+
+		CacheSimulator cache{ vertexCount, cacheSize };
+		size_t misses{};
+		for (size_t triangle{}; triangle < triangleCount; ++triangle)
+		{
+			misses += cache.Triangle(&indices[triangle * 3]);
+		}
+
+		return float(misses) / float(triangleCount);
+	}
+
+	float MeshOptimizer::CalculateOverdraw(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+	{
+		constexpr int gridSize{ 256 };
+		if (vertices.empty() || indices.size() < 3) return 0.f;
+
+		Vector3 minBounds{ vertices[0].position };
+		Vector3 maxBounds{ vertices[0].position };
+		for (const Vertex& vertex : vertices)
+		{
+			for (int axis{}; axis < 3; ++axis)
+			{
+				minBounds[axis] = std::min(minBounds[axis], vertex.position[axis]);
+				maxBounds[axis] = std::max(maxBounds[axis], vertex.position[axis]);
+			}
+		}
+		const Vector3 center{ (minBounds + maxBounds) * 0.5f };
+		const Vector3 extent{ maxBounds - minBounds };
+		const float scale{ (gridSize - 1) / std::max({ extent.x, extent.y, extent.z, FLT_EPSILON }) };
+		const float halfGrid{ gridSize * 0.5f };
+
+		std::vector<float> frontDepth(gridSize * gridSize);
+		std::vector<float> backDepth(gridSize * gridSize);
+		size_t shaded{};
+		size_t covered{};
+
+		for (int axis{}; axis < 3; ++axis)
+		{
+			// left handed view basis looking down the axis, same convention as Camera
+			const Vector3 forward{ axis == 0 ? Vector3::UnitX : axis == 1 ? Vector3::UnitY : Vector3::UnitZ };
+			const Vector3 up{ axis == 1 ? Vector3::UnitZ : Vector3::UnitY };
+			const Vector3 right{ Vector3::Cross(up, forward) };
+
+			std::fill(frontDepth.begin(), frontDepth.end(), FLT_MAX);
+			std::fill(backDepth.begin(), backDepth.end(), FLT_MAX);
+
+			for (size_t idx{}; idx + 2 < indices.size(); idx += 3)
+			{
+				Vector2 screen[3]{};
+				float depth[3]{};
+				for (int corner{}; corner < 3; ++corner)
+				{
+					const Vector3 p{ vertices[indices[idx + corner]].position - center };
+					// y points down like the renderer's screen space
+					screen[corner] = { halfGrid + Vector3::Dot(p, right) * scale, halfGrid - Vector3::Dot(p, up) * scale };
+					depth[corner] = Vector3::Dot(p, forward);
+				}
+
+				// same winding test as Renderer::IsPixelInTriangle: positive faces the viewer looking down +axis, negative the one looking down -axis
+				if (Vector2::Cross(screen[1] - screen[0], screen[2] - screen[0]) > 0.f)
+				{
+					RasterizeOverdraw(screen[0], screen[1], screen[2], depth[0], depth[1], depth[2], frontDepth, gridSize, shaded);
+				}
+				else
+				{
+					RasterizeOverdraw(screen[0], screen[1], screen[2], -depth[0], -depth[1], -depth[2], backDepth, gridSize, shaded);
+				}
+			}
+
+			covered += std::count_if(frontDepth.begin(), frontDepth.end(), [](float d) { return d != FLT_MAX; });
+			covered += std::count_if(backDepth.begin(), backDepth.end(), [](float d) { return d != FLT_MAX; });
+		}
+
+		return covered == 0 ? 0.f : float(shaded) / float(covered);
+	}
+}
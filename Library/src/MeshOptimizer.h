@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "DataTypes.h"
+
+namespace dae
+{
+	struct MeshOptimizationStats
+	{
+		size_t verticesBefore{};
+		size_t verticesAfter{};
+
+		// average cache miss ratio: transformed vertices per triangle (lower is better, 0.5 is ideal)
+		float acmrBefore{};
+		float acmrAfter{};
+
+		// shaded pixels per covered pixel, averaged over 6 axis aligned views (lower is better, 1 is ideal)
+		float overdrawBefore{};
+		float overdrawAfter{};
+	};
+
+	namespace MeshOptimizer
+	{
+		constexpr int CACHE_SIZE{ 16 };
+		constexpr uint32_t MESHLET_MAX_VERTICES{ 64 };
+		constexpr uint32_t MESHLET_MAX_TRIANGLES{ 124 };
+
+		// Runs every pass below in order on a triangle list mesh, returns before/after statistics
+		MeshOptimizationStats OptimizeMesh(Mesh& mesh);
+
+		// Merges vertices with equal position, uv, normal and color (the OBJ parser emits 3 per face)
+		void WeldVertices(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+		// Tipsify (Sander et al. 2007), optionally outputs the first triangle of every cluster
+		void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, std::vector<uint32_t>* pClusters = nullptr, int cacheSize = CACHE_SIZE);
+
+		// Sorts the clusters of OptimizeVertexCache so outward facing, outer clusters are drawn first
+		void OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& clusters, float threshold = 1.05f, int cacheSize = CACHE_SIZE);
+
+		// Reorders vertices by first use in the index buffer
+		void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+		// Splits a triangle list into meshlets in index order, run OptimizeMesh first for tight clusters
+		void BuildMeshlets(Mesh& mesh, uint32_t maxVertices = MESHLET_MAX_VERTICES, uint32_t maxTriangles = MESHLET_MAX_TRIANGLES);
+
+		float CalculateACMR(const std::vector<uint32_t>& indices, size_t vertexCount, int cacheSize = CACHE_SIZE);
+		float CalculateOverdraw(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+	}
+}
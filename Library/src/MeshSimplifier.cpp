@@ -0,0 +1,309 @@
+#include "MeshSimplifier.h"
+
+#include <cassert>
+#include <map>
+#include <queue>
+#include <tuple>
+
+#include "MeshOptimizer.h"
+
+namespace dae
+{
+	namespace
+	{
+		// symmetric 4x4 quadric, doubles because the sums of many small planes cancel badly in float
+		struct Quadric
+		{
+			double a00{}, a01{}, a02{}, a11{}, a12{}, a22{};
+			double b0{}, b1{}, b2{};
+			double c{};
+			double weight{};
+
+			static Quadric FromPlane(const Vector3& normal, float distance, float weight)
+			{
+				const double nx{ normal.x }, ny{ normal.y }, nz{ normal.z }, d{ distance };
+				Quadric q{};
+				q.a00 = nx * nx * weight; q.a01 = nx * ny * weight; q.a02 = nx * nz * weight;
+				q.a11 = ny * ny * weight; q.a12 = ny * nz * weight; q.a22 = nz * nz * weight;
+				q.b0 = nx * d * weight; q.b1 = ny * d * weight; q.b2 = nz * d * weight;
+				q.c = d * d * weight;
+				q.weight = weight;
+				return q;
+			}
+
+			Quadric& operator+=(const Quadric& q)
+			{
+				a00 += q.a00; a01 += q.a01; a02 += q.a02;
+				a11 += q.a11; a12 += q.a12; a22 += q.a22;
+				b0 += q.b0; b1 += q.b1; b2 += q.b2;
+				c += q.c;
+				weight += q.weight;
+				return *this;
+			}
+
+			// weighted mean of the squared distances to the accumulated planes
+			double Error(const Vector3& p) const
+			{
+				const double x{ p.x }, y{ p.y }, z{ p.z };
+				const double result{
+					a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z +
+					a11 * y * y + 2 * a12 * y * z +
+					a22 * z * z +
+					2 * (b0 * x + b1 * y + b2 * z) + c };
+				return weight > 0.0 ? std::max(result, 0.0) / weight : 0.0;
+			}
+		};
+
+		struct Collapse
+		{
+			float error{};
+			uint32_t from{};
+			uint32_t to{};
+			uint32_t stampFrom{};
+			uint32_t stampTo{};
+
+			bool operator>(const Collapse& other) const { return error > other.error; }
+		};
+
+		// every vertex starts with the planes of the triangles around it
+		std::vector<Quadric> ComputeQuadrics(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+		{
+			std::vector<Quadric> quadrics(vertices.size());
+			for (size_t idx{}; idx + 2 < indices.size(); idx += 3)
+			{
+				const Vector3& p0{ vertices[indices[idx]].position };
+				const Vector3& p1{ vertices[indices[idx + 1]].position };
+				const Vector3& p2{ vertices[indices[idx + 2]].position };
+
+				Vector3 normal{ Vector3::Cross(p1 - p0, p2 - p0) };
+				const float area{ normal.Magnitude() * 0.5f };
+				if (area > 0.f) normal /= (area * 2.f);
+
+				const Quadric plane{ Quadric::FromPlane(normal, -Vector3::Dot(normal, p0), area) };
+				for (int corner{}; corner < 3; ++corner) quadrics[indices[idx + corner]] += plane;
+			}
+			return quadrics;
+		}
+
+		// quadrics is updated in place, so feeding the result back in keeps measuring against the surface the quadrics were built from
+		std::vector<uint32_t> SimplifyWithQuadrics(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+			size_t targetIndexCount, float maxError, std::vector<Quadric>& quadrics, float* pResultError)
+		{
+			const size_t vertexCount{ vertices.size() };
+			const size_t triangleCount{ indices.size() / 3 };
+
+			std::vector<uint32_t> triangles{ indices };
+			std::vector<bool> isTriangleAlive(triangleCount, true);
+			std::vector<std::vector<uint32_t>> adjacency(vertexCount);
+
+			for (uint32_t triangle{}; triangle < triangleCount; ++triangle)
+			{
+				for (int corner{}; corner < 3; ++corner) adjacency[triangles[triangle * 3 + corner]].push_back(triangle);
+			}
+
+			// lock borders (edges with one triangle) and seams (vertices sharing a position), collapsing them tears the surface
+			std::vector<bool> isLocked(vertexCount, false);
+			{
+				std::map<std::pair<uint32_t, uint32_t>, int> edgeUse{};
+				for (size_t idx{}; idx < triangles.size(); idx += 3)
+				{
+					for (int corner{}; corner < 3; ++corner)
+					{
+						const uint32_t a{ triangles[idx + corner] };
+						const uint32_t b{ triangles[idx + (corner + 1) % 3] };
+						++edgeUse[{ std::min(a, b), std::max(a, b) }];
+					}
+				}
+				for (const auto& [edge, count] : edgeUse)
+				{
+					if (count == 1)
+					{
+						isLocked[edge.first] = true;
+						isLocked[edge.second] = true;
+					}
+				}
+
+				std::map<std::tuple<float, float, float>, uint32_t> positions{};
+				for (uint32_t vertex{}; vertex < vertexCount; ++vertex)
+				{
+					const Vector3& p{ vertices[vertex].position };
+					const auto result{ positions.try_emplace({ p.x, p.y, p.z }, vertex) };
+					if (!result.second)
+					{
+						isLocked[vertex] = true;
+						isLocked[result.first->second] = true;
+					}
+				}
+			}
+
+			std::vector<bool> isCollapsed(vertexCount, false);
+			std::vector<uint32_t> stamps(vertexCount, 0);
+			std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> queue{};
+
+			const auto pushEdge{ [&](uint32_t a, uint32_t b)
+				{
+					Quadric combined{ quadrics[a] };
+					combined += quadrics[b];
+
+					if (!isLocked[a])
+					{
+						queue.push({ float(sqrt(combined.Error(vertices[b].position))), a, b, stamps[a], stamps[b] });
+					}
+					if (!isLocked[b])
+					{
+						queue.push({ float(sqrt(combined.Error(vertices[a].position))), b, a, stamps[b], stamps[a] });
+					}
+				} };
+
+			for (size_t idx{}; idx < triangles.size(); idx += 3)
+			{
+				for (int corner{}; corner < 3; ++corner)
+				{
+					const uint32_t a{ triangles[idx + corner] };
+					const uint32_t b{ triangles[idx + (corner + 1) % 3] };
+					if (a < b) pushEdge(a, b);
+				}
+			}
+
+			// replacing 'from' by 'to' must not flip or collapse any remaining triangle
+			const auto isCollapseValid{ [&](uint32_t from, uint32_t to)
+				{
+					const Vector3& target{ vertices[to].position };
+					for (uint32_t triangle : adjacency[from])
+					{
+						if (!isTriangleAlive[triangle]) continue;
+
+						const uint32_t* pTriangle{ &triangles[triangle * 3] };
+						if (pTriangle[0] == to || pTriangle[1] == to || pTriangle[2] == to) continue;
+
+						Vector3 corners[3]{};
+						for (int corner{}; corner < 3; ++corner) corners[corner] = vertices[pTriangle[corner]].position;
+						const Vector3 oldNormal{ Vector3::Cross(corners[1] - corners[0], corners[2] - corners[0]) };
+						for (int corner{}; corner < 3; ++corner)
+						{
+							if (pTriangle[corner] == from) corners[corner] = target;
+						}
+						const Vector3 newNormal{ Vector3::Cross(corners[1] - corners[0], corners[2] - corners[0]) };
+
+						if (Vector3::Dot(oldNormal, newNormal) <= 0.25f * oldNormal.Magnitude() * newNormal.Magnitude()) return false;
+					}
+					return true;
+				} };
+
+			size_t liveTriangles{ triangleCount };
+			float resultError{};
+
+			while (!queue.empty() && liveTriangles * 3 > targetIndexCount)
+			{
+				const Collapse collapse{ queue.top() };
+				queue.pop();
+
+				if (collapse.error > maxError) break;
+				if (isCollapsed[collapse.from] || isCollapsed[collapse.to]) continue;
+				if (stamps[collapse.from] != collapse.stampFrom || stamps[collapse.to] != collapse.stampTo) continue;
+				if (!isCollapseValid(collapse.from, collapse.to)) continue;
+
+				for (uint32_t triangle : adjacency[collapse.from])
+				{
+					if (!isTriangleAlive[triangle]) continue;
+
+					uint32_t* pTriangle{ &triangles[triangle * 3] };
+					if (pTriangle[0] == collapse.to || pTriangle[1] == collapse.to || pTriangle[2] == collapse.to)
+					{
+						isTriangleAlive[triangle] = false;
+						--liveTriangles;
+						continue;
+					}
+
+					for (int corner{}; corner < 3; ++corner)
+					{
+						if (pTriangle[corner] == collapse.from) pTriangle[corner] = collapse.to;
+					}
+					adjacency[collapse.to].push_back(triangle);
+				}
+
+				quadrics[collapse.to] += quadrics[collapse.from];
+				isCollapsed[collapse.from] = true;
+				adjacency[collapse.from].clear();
+				++stamps[collapse.to];
+				resultError = std::max(resultError, collapse.error);
+
+				// re-evaluate every edge around the merged vertex
+				for (uint32_t triangle : adjacency[collapse.to])
+				{
+					if (!isTriangleAlive[triangle]) continue;
+
+					for (int corner{}; corner < 3; ++corner)
+					{
+						const uint32_t neighbour{ triangles[triangle * 3 + corner] };
+						if (neighbour != collapse.to) pushEdge(collapse.to, neighbour);
+					}
+				}
+			}
+
+			std::vector<uint32_t> result{};
+			result.reserve(liveTriangles * 3);
+			for (uint32_t triangle{}; triangle < triangleCount; ++triangle)
+			{
+				if (!isTriangleAlive[triangle]) continue;
+				result.insert(result.end(), triangles.begin() + triangle * 3, triangles.begin() + triangle * 3 + 3);
+			}
+
+			if (pResultError) *pResultError = resultError;
+			return result;
+		}
+	}
+
+	std::vector<uint32_t> MeshSimplifier::Simplify(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+		size_t targetIndexCount, float maxError, float* pResultError)
+	{
+		std::vector<Quadric> quadrics{ ComputeQuadrics(vertices, indices) };
+		return SimplifyWithQuadrics(vertices, indices, targetIndexCount, maxError, quadrics, pResultError);
+	}
+
+	void MeshSimplifier::BuildLODs(Mesh& mesh, int maxLevels, float maxRelativeError)
+	{
+		assert(mesh.primitiveTopology == PrimitiveTopology::TriangleList && "LODs are only supported for triangle lists");
+		mesh.lods.clear();
+		if (mesh.vertices.empty()) return;
+
+		// the parser emits unique vertices per face, which would make every edge a border
+		MeshOptimizer::WeldVertices(mesh.vertices, mesh.indices);
+
+		Vector3 minBounds{ mesh.vertices[0].position };
+		Vector3 maxBounds{ minBounds };
+		for (const Vertex& vertex : mesh.vertices)
+		{
+			for (int axis{}; axis < 3; ++axis)
+			{
+				minBounds[axis] = std::min(minBounds[axis], vertex.position[axis]);
+				maxBounds[axis] = std::max(maxBounds[axis], vertex.position[axis]);
+			}
+		}
+		const float maxError{ (maxBounds - minBounds).Magnitude() * maxRelativeError };
+
+		// the full resolution quadrics are carried from level to level, so every collapse is measured against the original surface
+		// instead of against the previous level, and maxError bounds the total deviation
+		std::vector<Quadric> quadrics{ ComputeQuadrics(mesh.vertices, mesh.indices) };
+
+		// pPrevious points into lods, it must never reallocate
+		mesh.lods.reserve(maxLevels);
+		const std::vector<uint32_t>* pPrevious{ &mesh.indices };
+		float totalError{};
+		for (int level{}; level < maxLevels; ++level)
+		{
+			// a failed level must not leave its collapses in the quadrics
+			std::vector<Quadric> levelQuadrics{ quadrics };
+			float error{};
+			std::vector<uint32_t> indices{ SimplifyWithQuadrics(mesh.vertices, *pPrevious, (pPrevious->size() / 6) * 3, maxError, levelQuadrics, &error) };
+
+			// stop once a level no longer pays for itself
+			if (indices.empty() || indices.size() > pPrevious->size() * 9 / 10) break;
+
+			quadrics = std::move(levelQuadrics);
+			totalError = std::max(totalError, error);
+			mesh.lods.push_back(MeshLOD{ std::move(indices), totalError });
+			pPrevious = &mesh.lods.back().indices;
+		}
+	}
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "DataTypes.h"
+
+namespace dae
+{
+	namespace MeshSimplifier
+	{
+		constexpr int MAX_LOD_LEVELS{ 4 };
+
+		// Quadric error metric edge collapse (Garland & Heckbert 1997) onto existing vertices.
+		// Border and uv/normal seam vertices are locked. Returns the new index buffer, pResultError receives the largest deviation.
+		std::vector<uint32_t> Simplify(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+			size_t targetIndexCount, float maxError, float* pResultError = nullptr);
+
+		// Welds the mesh and fills Mesh::lods with levels of roughly half the triangles of the previous one.
+		// maxRelativeError bounds every level's deviation from the full resolution mesh, relative to the bounds diagonal.
+		void BuildLODs(Mesh& mesh, int maxLevels = MAX_LOD_LEVELS, float maxRelativeError = 0.05f);
+	}
+}
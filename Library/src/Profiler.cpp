@@ -0,0 +1,154 @@
+#include "Profiler.h"
+#include "SDL.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+namespace dae
+{
+	Profiler& Profiler::Get()
+	{
+		static Profiler profiler{};
+		return profiler;
+	}
+
+	uint64_t Profiler::Now()
+	{
+		return SDL_GetPerformanceCounter();
+	}
+
+	double Profiler::ToMilliseconds(uint64_t counts)
+	{
+		static const double millisecondsPerCount{ 1000.0 / double(SDL_GetPerformanceFrequency()) };
+		return double(counts) * millisecondsPerCount;
+	}
+
+	Profiler::ThreadBuffer& Profiler::GetThreadBuffer()
+	{
+		thread_local ThreadBuffer* pBuffer{ nullptr };
+		if (!pBuffer)
+		{
+			std::lock_guard lock{ m_Mutex };
+			pBuffer = &m_ThreadBuffers.emplace_back();
+			pBuffer->threadIndex = uint32_t(m_ThreadBuffers.size() - 1);
+			pBuffer->threadId = std::this_thread::get_id();
+		}
+		return *pBuffer;
+	}
+
+	void Profiler::AddZone(const char* name, uint64_t begin, uint64_t end)
+	{
+		ThreadBuffer& buffer{ GetThreadBuffer() };
+		buffer.zones.push_back(Zone{ name, begin, end });
+		if (m_IsCapturing)
+		{
+			buffer.captured.push_back(Zone{ name, begin, end });
+		}
+	}
+
+	void Profiler::AddTime(const char* name, uint64_t counts)
+	{
+		GetThreadBuffer().times.emplace_back(name, counts);
+	}
+
+	void Profiler::EndFrame()
+	{
+		std::lock_guard lock{ m_Mutex };
+		m_MainThreadId = std::this_thread::get_id();
+
+		// zones with the same name are summed, over threads too
+		std::map<std::string, double> frameTotals{};
+		for (ThreadBuffer& buffer : m_ThreadBuffers)
+		{
+			for (const Zone& zone : buffer.zones)
+			{
+				frameTotals[zone.name] += ToMilliseconds(zone.end - zone.begin);
+			}
+			for (const auto& [name, counts] : buffer.times)
+			{
+				frameTotals[name] += ToMilliseconds(counts);
+			}
+			buffer.zones.clear();
+			buffer.times.clear();
+		}
+
+		for (const auto& [name, total] : frameTotals)
+		{
+			m_Summary.try_emplace(name);
+		}
+
+		// stages that didn't run this frame record 0 ms
+		for (auto& [name, summary] : m_Summary)
+		{
+			const auto it{ frameTotals.find(name) };
+			summary.history[summary.writeIdx] = (it != frameTotals.end()) ? it->second : 0.0;
+			summary.writeIdx = (summary.writeIdx + 1) % SUMMARY_FRAMES;
+			summary.frames = std::min(summary.frames + 1, SUMMARY_FRAMES);
+		}
+		m_LastFrame = std::move(frameTotals);
+	}
+
+	void Profiler::StartCapture()
+	{
+		std::lock_guard lock{ m_Mutex };
+		for (ThreadBuffer& buffer : m_ThreadBuffers)
+		{
+			buffer.captured.clear();
+		}
+		m_CaptureStart = Now();
+		m_IsCapturing = true;
+	}
+
+	bool Profiler::WriteChromeTrace(const std::string& path)
+	{
+		std::lock_guard lock{ m_Mutex };
+		m_IsCapturing = false;
+
+		std::ofstream file{ path };
+		if (!file)
+		{
+			return false;
+		}
+
+		const auto toMicroseconds{ [this](uint64_t counts) { return ToMilliseconds(counts - std::min(counts, m_CaptureStart)) * 1000.0; } };
+
+		file << std::fixed << std::setprecision(3) << "{\"traceEvents\":[\n";
+		bool isFirst{ true };
+		for (ThreadBuffer& buffer : m_ThreadBuffers)
+		{
+			file << (isFirst ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << buffer.threadIndex
+				<< ",\"args\":{\"name\":\"" << (buffer.threadId == m_MainThreadId ? "Main" : "Worker " + std::to_string(buffer.threadIndex)) << "\"}}";
+			isFirst = false;
+
+			for (const Zone& zone : buffer.captured)
+			{
+				file << ",\n{\"name\":\"" << zone.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer.threadIndex
+					<< ",\"ts\":" << toMicroseconds(zone.begin) << ",\"dur\":" << ToMilliseconds(zone.end - zone.begin) * 1000.0 << "}";
+			}
+			buffer.captured.clear();
+		}
+		file << "\n]}\n";
+
+		return bool(file);
+	}
+
+	void Profiler::PrintSummary(std::ostream& os) const
+	{
+		os << std::fixed << std::setprecision(3);
+		for (const auto& [name, summary] : m_Summary)
+		{
+			if (summary.frames == 0) continue;
+
+			double total{}, maximum{};
+			for (size_t idx{}; idx < summary.frames; ++idx)
+			{
+				total += summary.history[idx];
+				maximum = std::max(maximum, summary.history[idx]);
+			}
+
+			os << std::left << std::setw(20) << name << " avg " << total / double(summary.frames) << " ms, max " << maximum << " ms\n";
+		}
+		os << std::defaultfloat;
+	}
+}
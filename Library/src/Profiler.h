@@ -0,0 +1,144 @@
+#pragma once
+
+//Standard includes
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Zones cost two performance counter reads, define DISABLE_PROFILER to compile every PROFILE_ macro to nothing
+#ifndef DISABLE_PROFILER
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+// timed scope, shows up in the trace and in the summary
+#define PROFILE_ZONE(name) const dae::ProfileZone PROFILE_CONCAT(profileZone, __LINE__){ name }
+
+// for stages too fine grained for a zone each: declare a counter, accumulate scopes into it, submit the total once
+#define PROFILE_COUNTER(counter) uint64_t counter{}
+#define PROFILE_ACCUMULATE(counter) const dae::ProfileAccumulator PROFILE_CONCAT(profileAccumulator, __LINE__){ counter }
+#define PROFILE_SUBMIT(name, counter) dae::Profiler::Get().AddTime(name, counter)
+#else
+#define PROFILE_ZONE(name)
+#define PROFILE_COUNTER(counter)
+#define PROFILE_ACCUMULATE(counter)
+#define PROFILE_SUBMIT(name, counter)
+#endif
+
+namespace dae
+{
+	class Profiler final
+	{
+	public:
+		static Profiler& Get();
+
+		Profiler(const Profiler&) = delete;
+		Profiler(Profiler&&) noexcept = delete;
+		Profiler& operator=(const Profiler&) = delete;
+		Profiler& operator=(Profiler&&) noexcept = delete;
+
+		// same clock as Timer
+		static uint64_t Now();
+		static double ToMilliseconds(uint64_t counts);
+
+		// Folds the zones of the finished frame into the rolling summary, call it when no zone is open on any thread
+		void EndFrame();
+
+		void AddZone(const char* name, uint64_t begin, uint64_t end);
+		// summary only, for time accumulated over many small scopes
+		void AddTime(const char* name, uint64_t counts);
+
+		// Zones are only kept for the trace between StartCapture and WriteChromeTrace
+		void StartCapture();
+		bool IsCapturing() const { return m_IsCapturing; };
+		// Chrome trace event JSON, open it in chrome://tracing or ui.perfetto.dev
+		bool WriteChromeTrace(const std::string& path);
+
+		// average and max milliseconds per frame of every stage over the last SUMMARY_FRAMES frames
+		void PrintSummary(std::ostream& os) const;
+		// milliseconds per stage of the frame finished by the last EndFrame
+		const std::map<std::string, double>& GetLastFrame() const { return m_LastFrame; };
+
+		static constexpr size_t SUMMARY_FRAMES{ 120 };
+
+	private:
+		Profiler() = default;
+
+		struct Zone
+		{
+			const char* name{};
+			uint64_t begin{};
+			uint64_t end{};
+		};
+
+		struct ThreadBuffer
+		{
+			uint32_t threadIndex{};
+			std::thread::id threadId{};
+			std::vector<Zone> zones{};
+			std::vector<Zone> captured{};
+			// (name, counts) added with AddTime since the last EndFrame
+			std::vector<std::pair<const char*, uint64_t>> times{};
+		};
+
+		struct StageSummary
+		{
+			double history[SUMMARY_FRAMES]{};
+			// its own ring position, a stage that first shows up late starts filling at slot 0 like PrintSummary expects
+			size_t writeIdx{};
+			size_t frames{};
+		};
+
+		ThreadBuffer& GetThreadBuffer();
+
+		// one buffer per thread that ever recorded a zone, deque so the thread_local pointers stay valid
+		std::deque<ThreadBuffer> m_ThreadBuffers{};
+		std::mutex m_Mutex{};
+
+		std::map<std::string, StageSummary> m_Summary{};
+		std::map<std::string, double> m_LastFrame{};
+		// the thread calling EndFrame, labeled Main in the trace
+		std::thread::id m_MainThreadId{};
+
+		// read by every thread that records a zone
+		std::atomic<bool> m_IsCapturing{ false };
+		uint64_t m_CaptureStart{};
+	};
+
+	class ProfileZone final
+	{
+	public:
+		explicit ProfileZone(const char* name) : m_pName{ name }, m_Begin{ Profiler::Now() } {};
+		~ProfileZone() { Profiler::Get().AddZone(m_pName, m_Begin, Profiler::Now()); };
+
+		ProfileZone(const ProfileZone&) = delete;
+		ProfileZone(ProfileZone&&) noexcept = delete;
+		ProfileZone& operator=(const ProfileZone&) = delete;
+		ProfileZone& operator=(ProfileZone&&) noexcept = delete;
+
+	private:
+		const char* m_pName;
+		uint64_t m_Begin;
+	};
+
+	class ProfileAccumulator final
+	{
+	public:
+		explicit ProfileAccumulator(uint64_t& counter) : m_Counter{ counter }, m_Begin{ Profiler::Now() } {};
+		~ProfileAccumulator() { m_Counter += Profiler::Now() - m_Begin; };
+
+		ProfileAccumulator(const ProfileAccumulator&) = delete;
+		ProfileAccumulator(ProfileAccumulator&&) noexcept = delete;
+		ProfileAccumulator& operator=(const ProfileAccumulator&) = delete;
+		ProfileAccumulator& operator=(ProfileAccumulator&&) noexcept = delete;
+
+	private:
+		uint64_t& m_Counter;
+		uint64_t m_Begin;
+	};
+}
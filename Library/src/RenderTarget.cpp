@@ -0,0 +1,343 @@
+#include "RenderTarget.h"
+#include "Maths.h"
+#include "SDL.h"
+
+//Standard includes
+#include <cassert>
+#include <new>
+
+namespace dae
+{
+	void RenderTarget::Fill(const ScreenRect& rect, uint32_t pixel)
+	{
+		for (int y{ rect.minY }; y < rect.maxY; ++y)
+		{
+			std::fill(GetRow(y) + rect.minX, GetRow(y) + rect.maxX, pixel);
+		}
+	}
+
+	bool RenderTarget::SaveToBMP(const std::string& path) const
+	{
+		SDL_Surface* pSurface{ SDL_CreateRGBSurfaceWithFormatFrom(const_cast<uint32_t*>(m_pPixels), m_Width, m_Height, 32, m_Stride * int(sizeof(uint32_t)), SDL_PIXELFORMAT_RGB888) };
+		if (!pSurface)
+		{
+			return false;
+		}
+
+		const bool isSaved{ SDL_SaveBMP(pSurface, path.c_str()) == 0 };
+		SDL_FreeSurface(pSurface);
+		return isSaved;
+	}
+
+	void RenderTarget::UpscaleBilinear(const RenderTarget& source, RenderTarget& destination, const ScreenRect& rect)
+	{
+		// pixel centers mapped onto the source, as the first of two neighbours and an 8 bit weight for the second
+		const auto toSource{ [](int destinationIdx, int sourceSize, int destinationSize, int& sourceIdx, int& weight)
+			{
+				const float position{ std::clamp((destinationIdx + 0.5f) * sourceSize / destinationSize - 0.5f, 0.f, float(sourceSize - 1)) };
+				sourceIdx = std::min(int(position), std::max(sourceSize - 2, 0));
+				weight = std::min(int((position - sourceIdx) * 256.f + 0.5f), 256);
+			} };
+
+		std::vector<int> columns(std::max(rect.maxX - rect.minX, 0));
+		std::vector<int> columnWeights(columns.size());
+		for (int x{ rect.minX }; x < rect.maxX; ++x)
+		{
+			toSource(x, source.m_Width, destination.m_Width, columns[x - rect.minX], columnWeights[x - rect.minX]);
+		}
+
+		for (int y{ rect.minY }; y < rect.maxY; ++y)
+		{
+			int y0{}, fy{};
+			toSource(y, source.m_Height, destination.m_Height, y0, fy);
+			const uint32_t* pRow0{ source.GetRow(y0) };
+			const uint32_t* pRow1{ source.GetRow(std::min(y0 + 1, source.m_Height - 1)) };
+			uint32_t* pDestinationRow{ destination.GetRow(y) };
+
+			for (int x{ rect.minX }; x < rect.maxX; ++x)
+			{
+				const int x0{ columns[x - rect.minX] };
+				const int x1{ std::min(x0 + 1, source.m_Width - 1) };
+				const int fx{ columnWeights[x - rect.minX] };
+#ifdef DAE_USE_SSE2
+				// all four channels of the left and right texel as 16 bit lanes, weights stay below 2^16 since 255 * 256 does
+				const __m128i zero{ _mm_setzero_si128() };
+				const __m128i horizontalWeights{ _mm_setr_epi16(short(256 - fx), short(256 - fx), short(256 - fx), short(256 - fx), short(fx), short(fx), short(fx), short(fx)) };
+				__m128i top{ _mm_mullo_epi16(_mm_unpacklo_epi8(_mm_set_epi32(0, 0, int(pRow0[x1]), int(pRow0[x0])), zero), horizontalWeights) };
+				__m128i bottom{ _mm_mullo_epi16(_mm_unpacklo_epi8(_mm_set_epi32(0, 0, int(pRow1[x1]), int(pRow1[x0])), zero), horizontalWeights) };
+				top = _mm_srli_epi16(_mm_add_epi16(top, _mm_srli_si128(top, 8)), 8);
+				bottom = _mm_srli_epi16(_mm_add_epi16(bottom, _mm_srli_si128(bottom, 8)), 8);
+				__m128i blended{ _mm_add_epi16(_mm_mullo_epi16(top, _mm_set1_epi16(short(256 - fy))), _mm_mullo_epi16(bottom, _mm_set1_epi16(short(fy)))) };
+				blended = _mm_srli_epi16(blended, 8);
+				pDestinationRow[x] = uint32_t(_mm_cvtsi128_si32(_mm_packus_epi16(blended, blended)));
+#else
+				uint32_t pixel{};
+				for (int shift{}; shift < 32; shift += 8)
+				{
+					const uint32_t top{ (((pRow0[x0] >> shift) & 0xff) * (256 - fx) + ((pRow0[x1] >> shift) & 0xff) * fx) >> 8 };
+					const uint32_t bottom{ (((pRow1[x0] >> shift) & 0xff) * (256 - fx) + ((pRow1[x1] >> shift) & 0xff) * fx) >> 8 };
+					pixel |= ((top * (256 - fy) + bottom * fy) >> 8) << shift;
+				}
+				pDestinationRow[x] = pixel;
+#endif
+			}
+		}
+	}
+
+	int RenderTarget::CalculateStride(int width)
+	{
+		constexpr size_t pixelsPerAlignment{ ROW_ALIGNMENT / sizeof(uint32_t) };
+		return int((size_t(width) + pixelsPerAlignment - 1) / pixelsPerAlignment * pixelsPerAlignment);
+	}
+
+	uint32_t* RenderTarget::AllocatePixels(int stride, int height)
+	{
+		uint32_t* pPixels{ static_cast<uint32_t*>(::operator new[](size_t(stride) * height * sizeof(uint32_t), std::align_val_t{ ROW_ALIGNMENT })) };
+		std::fill(pPixels, pPixels + size_t(stride) * height, 0);
+		return pPixels;
+	}
+
+	void RenderTarget::FreePixels(uint32_t* pPixels)
+	{
+		::operator delete[](pPixels, std::align_val_t{ ROW_ALIGNMENT });
+	}
+
+	MemoryRenderTarget::MemoryRenderTarget(int width, int height, SDL_Window* pPresentWindow) :
+		RenderTarget(width, height),
+		m_MaxWidth{ width },
+		m_MaxHeight{ height },
+		m_pPresentWindow{ pPresentWindow }
+	{
+		m_Stride = CalculateStride(width);
+		m_pPixels = AllocatePixels(m_Stride, height);
+
+		if (m_pPresentWindow)
+		{
+			m_pSurface = SDL_CreateRGBSurfaceWithFormatFrom(m_pPixels, width, height, 32, m_Stride * int(sizeof(uint32_t)), SDL_PIXELFORMAT_RGB888);
+		}
+	}
+
+	MemoryRenderTarget::~MemoryRenderTarget()
+	{
+		SDL_FreeSurface(m_pSurface);
+		FreePixels(m_pPixels);
+	}
+
+	void MemoryRenderTarget::Present(const ScreenRect& rect)
+	{
+		if (!m_pPresentWindow || rect.IsEmpty())
+		{
+			return;
+		}
+
+		// the window still shows the previous frame outside rect
+		SDL_Rect sdlRect{ rect.minX, rect.minY, rect.maxX - rect.minX, rect.maxY - rect.minY };
+		SDL_BlitSurface(m_pSurface, &sdlRect, SDL_GetWindowSurface(m_pPresentWindow), &sdlRect);
+		SDL_UpdateWindowSurfaceRects(m_pPresentWindow, &sdlRect, 1);
+	}
+
+	WindowRenderTarget::WindowRenderTarget(SDL_Window* pWindow) :
+		RenderTarget(0, 0),
+		m_pWindow{ pWindow },
+		m_pSurface{ SDL_GetWindowSurface(pWindow) }
+	{
+		// kept locked for the target's lifetime, the renderer writes whenever it wants
+		if (SDL_MUSTLOCK(m_pSurface))
+		{
+			SDL_LockSurface(m_pSurface);
+		}
+
+		m_Width = m_pSurface->w;
+		m_Height = m_pSurface->h;
+		m_Stride = m_pSurface->pitch / int(sizeof(uint32_t));
+		m_pPixels = static_cast<uint32_t*>(m_pSurface->pixels);
+	}
+
+	WindowRenderTarget::~WindowRenderTarget()
+	{
+		if (SDL_MUSTLOCK(m_pSurface))
+		{
+			SDL_UnlockSurface(m_pSurface);
+		}
+	}
+
+	bool WindowRenderTarget::IsSupported(SDL_Window* pWindow)
+	{
+		const SDL_Surface* pSurface{ SDL_GetWindowSurface(pWindow) };
+		return pSurface && pSurface->format->format == SDL_PIXELFORMAT_RGB888 && pSurface->pitch % sizeof(uint32_t) == 0;
+	}
+
+	void WindowRenderTarget::Present(const ScreenRect& rect)
+	{
+		if (rect.IsEmpty())
+		{
+			return;
+		}
+
+		SDL_Rect sdlRect{ rect.minX, rect.minY, rect.maxX - rect.minX, rect.maxY - rect.minY };
+		SDL_UpdateWindowSurfaceRects(m_pWindow, &sdlRect, 1);
+	}
+
+	bool MemoryRenderTarget::SetSize(int width, int height)
+	{
+		if (width < 1 || height < 1 || width > m_MaxWidth || height > m_MaxHeight)
+		{
+			return false;
+		}
+
+		m_Width = width;
+		m_Height = height;
+		return true;
+	}
+
+	SwapChainRenderTarget::SwapChainRenderTarget(int width, int height, SDL_Window* pPresentWindow, int bufferCount) :
+		RenderTarget(width, height),
+		m_pPresentWindow{ pPresentWindow },
+		m_pWindowSurface{ pPresentWindow ? SDL_GetWindowSurface(pPresentWindow) : nullptr }
+	{
+		// a resize would free the surface the present thread blits into
+		assert(!pPresentWindow || !(SDL_GetWindowFlags(pPresentWindow) & SDL_WINDOW_RESIZABLE));
+
+		m_Stride = CalculateStride(width);
+		m_Buffers.resize(std::max(bufferCount, 2));
+		for (Buffer& buffer : m_Buffers)
+		{
+			buffer.pPixels = AllocatePixels(m_Stride, height);
+			buffer.pSurface = SDL_CreateRGBSurfaceWithFormatFrom(buffer.pPixels, width, height, 32, m_Stride * int(sizeof(uint32_t)), SDL_PIXELFORMAT_RGB888);
+		}
+		m_pPixels = m_Buffers[m_BackBufferIdx].pPixels;
+
+		m_PresentThread = std::thread{ &SwapChainRenderTarget::PresentLoop, this };
+	}
+
+	SwapChainRenderTarget::~SwapChainRenderTarget()
+	{
+		Flush();
+		{
+			std::lock_guard lock{ m_Mutex };
+			m_IsStopping = true;
+		}
+		m_Condition.notify_all();
+		m_PresentThread.join();
+
+		for (Buffer& buffer : m_Buffers)
+		{
+			SDL_FreeSurface(buffer.pSurface);
+			FreePixels(buffer.pPixels);
+		}
+	}
+
+	void SwapChainRenderTarget::Present(const ScreenRect& rect)
+	{
+		// nothing changed, but the last frame may only have been blitted since the previous call
+		if (rect.IsEmpty())
+		{
+			UpdateWindow();
+			return;
+		}
+
+		const int frontBufferIdx{ m_BackBufferIdx };
+		const int nextBufferIdx{ (m_BackBufferIdx + 1) % int(m_Buffers.size()) };
+		{
+			std::unique_lock lock{ m_Mutex };
+			m_PresentQueue.emplace_back(frontBufferIdx, rect);
+			m_Condition.notify_all();
+
+			// this is the only wait, it bounds the queue to the other buffers
+			m_Condition.wait(lock, [this, nextBufferIdx]() { return !IsBufferInUse(nextBufferIdx); });
+		}
+		UpdateWindow();
+
+		for (int idx{}; idx < int(m_Buffers.size()); ++idx)
+		{
+			if (idx != frontBufferIdx) m_Buffers[idx].staleRect.Merge(rect);
+		}
+
+		// the present thread only reads the front buffer as well
+		Buffer& nextBuffer{ m_Buffers[nextBufferIdx] };
+		const ScreenRect& staleRect{ nextBuffer.staleRect };
+		for (int y{ staleRect.minY }; y < staleRect.maxY; ++y)
+		{
+			const uint32_t* pSourceRow{ m_Buffers[frontBufferIdx].pPixels + size_t(y) * m_Stride };
+			std::copy(pSourceRow + staleRect.minX, pSourceRow + staleRect.maxX, nextBuffer.pPixels + size_t(y) * m_Stride + staleRect.minX);
+		}
+		nextBuffer.staleRect = {};
+
+		m_BackBufferIdx = nextBufferIdx;
+		m_pPixels = nextBuffer.pPixels;
+	}
+
+	void SwapChainRenderTarget::Flush()
+	{
+		{
+			std::unique_lock lock{ m_Mutex };
+			m_Condition.wait(lock, [this]() { return m_PresentQueue.empty() && m_PresentingBufferIdx == -1; });
+		}
+		UpdateWindow();
+	}
+
+	void SwapChainRenderTarget::UpdateWindow()
+	{
+		std::vector<ScreenRect> rects{};
+		{
+			std::lock_guard lock{ m_Mutex };
+			rects.swap(m_BlittedRects);
+		}
+		if (rects.empty())
+		{
+			return;
+		}
+
+		std::vector<SDL_Rect> sdlRects{};
+		sdlRects.reserve(rects.size());
+		for (const ScreenRect& rect : rects)
+		{
+			sdlRects.push_back(SDL_Rect{ rect.minX, rect.minY, rect.maxX - rect.minX, rect.maxY - rect.minY });
+		}
+
+		std::lock_guard surfaceLock{ m_WindowSurfaceMutex };
+		SDL_UpdateWindowSurfaceRects(m_pPresentWindow, sdlRects.data(), int(sdlRects.size()));
+	}
+
+	void SwapChainRenderTarget::PresentLoop()
+	{
+		while (true)
+		{
+			std::pair<int, ScreenRect> frame{};
+			{
+				std::unique_lock lock{ m_Mutex };
+				m_Condition.wait(lock, [this]() { return m_IsStopping || !m_PresentQueue.empty(); });
+				if (m_PresentQueue.empty())
+				{
+					return;
+				}
+
+				frame = m_PresentQueue.front();
+				m_PresentQueue.pop_front();
+				m_PresentingBufferIdx = frame.first;
+			}
+
+			// only the copy into the window surface happens here, the window is updated on its own thread by UpdateWindow
+			if (m_pWindowSurface)
+			{
+				const ScreenRect& rect{ frame.second };
+				SDL_Rect sdlRect{ rect.minX, rect.minY, rect.maxX - rect.minX, rect.maxY - rect.minY };
+				std::lock_guard surfaceLock{ m_WindowSurfaceMutex };
+				SDL_BlitSurface(m_Buffers[frame.first].pSurface, &sdlRect, m_pWindowSurface, &sdlRect);
+			}
+
+			{
+				std::lock_guard lock{ m_Mutex };
+				m_PresentingBufferIdx = -1;
+				if (m_pWindowSurface) m_BlittedRects.push_back(frame.second);
+			}
+			m_Condition.notify_all();
+		}
+	}
+
+	bool SwapChainRenderTarget::IsBufferInUse(int bufferIdx) const
+	{
+		if (bufferIdx == m_PresentingBufferIdx) return true;
+		return std::any_of(m_PresentQueue.begin(), m_PresentQueue.end(), [bufferIdx](const std::pair<int, ScreenRect>& frame) { return frame.first == bufferIdx; });
+	}
+}
@@ -0,0 +1,192 @@
+#pragma once
+
+//Standard includes
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+struct SDL_Window;
+struct SDL_Surface;
+
+namespace dae
+{
+	// pixel rectangle [minX, maxX) x [minY, maxY)
+	struct ScreenRect
+	{
+		int minX{};
+		int minY{};
+		int maxX{};
+		int maxY{};
+
+		bool IsEmpty() const { return minX >= maxX || minY >= maxY; };
+		size_t GetArea() const { return IsEmpty() ? 0 : size_t(maxX - minX) * size_t(maxY - minY); };
+
+		void Merge(const ScreenRect& other)
+		{
+			if (other.IsEmpty()) return;
+			if (IsEmpty())
+			{
+				*this = other;
+				return;
+			}
+
+			minX = std::min(minX, other.minX);
+			minY = std::min(minY, other.minY);
+			maxX = std::max(maxX, other.maxX);
+			maxY = std::max(maxY, other.maxY);
+		}
+	};
+
+	// 32 bit XRGB color buffer the renderer draws into
+	class RenderTarget
+	{
+	public:
+		virtual ~RenderTarget() = default;
+
+		RenderTarget(const RenderTarget&) = delete;
+		RenderTarget(RenderTarget&&) noexcept = delete;
+		RenderTarget& operator=(const RenderTarget&) = delete;
+		RenderTarget& operator=(RenderTarget&&) noexcept = delete;
+
+		int GetWidth() const { return m_Width; };
+		int GetHeight() const { return m_Height; };
+		// pixels per row, can be more than the width
+		int GetStride() const { return m_Stride; };
+		uint32_t* GetPixels() { return m_pPixels; };
+		const uint32_t* GetPixels() const { return m_pPixels; };
+		uint32_t* GetRow(int y) { return m_pPixels + size_t(y) * m_Stride; };
+		const uint32_t* GetRow(int y) const { return m_pPixels + size_t(y) * m_Stride; };
+
+		static constexpr uint32_t MapRGB(uint8_t r, uint8_t g, uint8_t b) { return (uint32_t(r) << 16) | (uint32_t(g) << 8) | uint32_t(b); };
+		static constexpr void GetRGB(uint32_t pixel, uint8_t& r, uint8_t& g, uint8_t& b)
+		{
+			r = uint8_t(pixel >> 16);
+			g = uint8_t(pixel >> 8);
+			b = uint8_t(pixel);
+		};
+
+		void Fill(const ScreenRect& rect, uint32_t pixel);
+
+		// makes the pixels inside rect visible, if the target is shown anywhere
+		virtual void Present(const ScreenRect& rect) = 0;
+
+		bool SaveToBMP(const std::string& path) const;
+
+		// Fills rect of destination with source stretched over all of destination, bilinearly filtered. Rows of one
+		// destination can be split over threads.
+		static void UpscaleBilinear(const RenderTarget& source, RenderTarget& destination, const ScreenRect& rect);
+
+		// every row starts on a cache line
+		static constexpr size_t ROW_ALIGNMENT{ 64 };
+
+	protected:
+		RenderTarget(int width, int height) : m_Width{ width }, m_Height{ height } {};
+
+		static int CalculateStride(int width);
+		// zeroed, free with FreePixels
+		static uint32_t* AllocatePixels(int stride, int height);
+		static void FreePixels(uint32_t* pPixels);
+
+		int m_Width;
+		int m_Height;
+		int m_Stride{};
+		uint32_t* m_pPixels{ nullptr };
+	};
+
+	// Framebuffer in plain memory, rows start on a cache line. Without a window it never touches SDL's video
+	// subsystem, with one every Present copies the rectangle to the window surface.
+	class MemoryRenderTarget final : public RenderTarget
+	{
+	public:
+		MemoryRenderTarget(int width, int height, SDL_Window* pPresentWindow = nullptr);
+		~MemoryRenderTarget() override;
+
+		void Present(const ScreenRect& rect) override;
+
+		// Uses the top left width x height of the pixels, no larger than the creation size. Nothing is reallocated,
+		// the stride stays the same.
+		bool SetSize(int width, int height);
+
+	private:
+		const int m_MaxWidth;
+		const int m_MaxHeight;
+		SDL_Window* m_pPresentWindow;
+		// view on m_pPixels used as blit source, only created with a window
+		SDL_Surface* m_pSurface{ nullptr };
+	};
+
+	// Draws straight into the window surface, Present only tells SDL which rectangle changed so no pixel is copied or
+	// converted on our side. Needs a 32 bit XRGB window surface, check IsSupported first. Invalid once the window is resized.
+	class WindowRenderTarget final : public RenderTarget
+	{
+	public:
+		explicit WindowRenderTarget(SDL_Window* pWindow);
+		~WindowRenderTarget() override;
+
+		static bool IsSupported(SDL_Window* pWindow);
+
+		void Present(const ScreenRect& rect) override;
+
+	private:
+		SDL_Window* m_pWindow;
+		SDL_Surface* m_pSurface;
+	};
+
+	// Several framebuffers, the window is updated on a present thread while the next frame is drawn into another one.
+	// Present hands the frame over and only waits for the next buffer to be free, so at most bufferCount - 1 frames
+	// are queued up and bufferCount 2 adds one frame of latency. The buffers are kept in sync by copying the rectangles
+	// they missed, so the pixels outside a dirty rectangle are always those of the previous frame.
+	class SwapChainRenderTarget final : public RenderTarget
+	{
+	public:
+		// Without a window the frames are only handed through the queue. The window surface is fetched once, like
+		// WindowRenderTarget does, so the window must not be resizable. The present thread only blits into that surface,
+		// Present and Flush show the blitted rectangles and must be called from the thread that owns the window.
+		SwapChainRenderTarget(int width, int height, SDL_Window* pPresentWindow, int bufferCount = 2);
+		~SwapChainRenderTarget() override;
+
+		void Present(const ScreenRect& rect) override;
+
+		// blocks until every handed over frame is on the window
+		void Flush();
+
+		int GetBufferCount() const { return int(m_Buffers.size()); };
+
+	private:
+		struct Buffer
+		{
+			uint32_t* pPixels{ nullptr };
+			SDL_Surface* pSurface{ nullptr };
+			// changed by frames drawn into other buffers since this one was drawn into
+			ScreenRect staleRect{};
+		};
+
+		void PresentLoop();
+		bool IsBufferInUse(int bufferIdx) const;
+		// shows what the present thread blitted since the last call, on the calling thread
+		void UpdateWindow();
+
+		SDL_Window* m_pPresentWindow;
+		SDL_Surface* m_pWindowSurface{ nullptr };
+		// held while the window surface is written or shown
+		std::mutex m_WindowSurfaceMutex{};
+		std::vector<Buffer> m_Buffers{};
+		int m_BackBufferIdx{};
+
+		// (buffer, rectangle) waiting to be shown, guarded by m_Mutex like the three members after it
+		std::deque<std::pair<int, ScreenRect>> m_PresentQueue{};
+		int m_PresentingBufferIdx{ -1 };
+		// blitted into the window surface, not yet shown
+		std::vector<ScreenRect> m_BlittedRects{};
+		bool m_IsStopping{ false };
+		std::mutex m_Mutex{};
+		std::condition_variable m_Condition{};
+		std::thread m_PresentThread{};
+	};
+}
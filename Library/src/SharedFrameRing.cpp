@@ -0,0 +1,276 @@
+#include "SharedFrameRing.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//Standard includes
+#include <algorithm>
+#include <new>
+
+namespace dae
+{
+	namespace
+	{
+		constexpr size_t CACHE_LINE{ 64 };
+
+		size_t GetSlotOffset(int slotIdx)
+		{
+			return CACHE_LINE + size_t(slotIdx) * CACHE_LINE;
+		}
+
+		size_t GetPixelOffset(int slotCount)
+		{
+			return GetSlotOffset(slotCount);
+		}
+
+		size_t GetFrameSize(const SharedFrameRingHeader& header)
+		{
+			return size_t(header.stride) * header.height * sizeof(uint32_t);
+		}
+
+		SharedFrameRingHeader* GetHeader(void* pMemory)
+		{
+			return static_cast<SharedFrameRingHeader*>(pMemory);
+		}
+
+		SharedFrameSlot* GetSlot(void* pMemory, int slotIdx)
+		{
+			return reinterpret_cast<SharedFrameSlot*>(static_cast<uint8_t*>(pMemory) + GetSlotOffset(slotIdx));
+		}
+
+		uint32_t* GetPixels(void* pMemory, int slotIdx)
+		{
+			const SharedFrameRingHeader& header{ *GetHeader(pMemory) };
+			return reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(pMemory) + GetPixelOffset(header.slotCount) + GetFrameSize(header) * slotIdx);
+		}
+
+		// writable mapping of size bytes, created if needed
+		void* CreateMapping(const std::string& name, size_t size, intptr_t& handle)
+		{
+#ifdef _WIN32
+			const HANDLE mapping{ CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, DWORD(uint64_t(size) >> 32), DWORD(size), ("Local\\" + name).c_str()) };
+			if (!mapping) return nullptr;
+			void* pMemory{ MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size) };
+			if (!pMemory)
+			{
+				CloseHandle(mapping);
+				return nullptr;
+			}
+			handle = reinterpret_cast<intptr_t>(mapping);
+			return pMemory;
+#else
+			const int fileDescriptor{ shm_open(("/" + name).c_str(), O_CREAT | O_RDWR, 0600) };
+			if (fileDescriptor < 0) return nullptr;
+			void* pMemory{ ftruncate(fileDescriptor, off_t(size)) == 0 ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0) : MAP_FAILED };
+			if (pMemory == MAP_FAILED)
+			{
+				close(fileDescriptor);
+				return nullptr;
+			}
+			handle = fileDescriptor;
+			return pMemory;
+#endif
+		}
+
+		// read only mapping of an existing ring, size is taken from the header
+		void* OpenMapping(const std::string& name, size_t& size, intptr_t& handle)
+		{
+#ifdef _WIN32
+			const HANDLE mapping{ OpenFileMappingA(FILE_MAP_READ, FALSE, ("Local\\" + name).c_str()) };
+			if (!mapping) return nullptr;
+			void* pMemory{ MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) };
+			if (!pMemory)
+			{
+				CloseHandle(mapping);
+				return nullptr;
+			}
+			MEMORY_BASIC_INFORMATION info{};
+			VirtualQuery(pMemory, &info, sizeof(info));
+			size = info.RegionSize;
+			handle = reinterpret_cast<intptr_t>(mapping);
+			return pMemory;
+#else
+			const int fileDescriptor{ shm_open(("/" + name).c_str(), O_RDONLY, 0) };
+			if (fileDescriptor < 0) return nullptr;
+			struct stat info{};
+			void* pMemory{ fstat(fileDescriptor, &info) == 0 && info.st_size > 0 ? mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_SHARED, fileDescriptor, 0) : MAP_FAILED };
+			if (pMemory == MAP_FAILED)
+			{
+				close(fileDescriptor);
+				return nullptr;
+			}
+			size = size_t(info.st_size);
+			handle = fileDescriptor;
+			return pMemory;
+#endif
+		}
+
+		void CloseMapping(void* pMemory, size_t size, intptr_t handle)
+		{
+#ifdef _WIN32
+			(void)size;
+			UnmapViewOfFile(pMemory);
+			CloseHandle(reinterpret_cast<HANDLE>(handle));
+#else
+			munmap(pMemory, size);
+			close(int(handle));
+#endif
+		}
+	}
+
+	SharedFrameRingWriter::SharedFrameRingWriter(const std::string& name, int width, int height, int slotCount) :
+		m_Name{ name }
+	{
+		slotCount = std::max(slotCount, 2);
+		const int stride{ width };
+		m_Size = GetPixelOffset(slotCount) + size_t(stride) * height * sizeof(uint32_t) * slotCount;
+		m_pMemory = CreateMapping(name, m_Size, m_Handle);
+		if (!m_pMemory)
+		{
+			return;
+		}
+
+		// readers that attach from here on see latestFrame 0 until the first frame is done
+		SharedFrameRingHeader* pHeader{ new (m_pMemory) SharedFrameRingHeader{ SharedFrameRingHeader::MAGIC, SharedFrameRingHeader::VERSION, width, height, stride, slotCount, {} } };
+		pHeader->latestFrame.store(0, std::memory_order_release);
+		for (int idx{}; idx < slotCount; ++idx)
+		{
+			new (GetSlot(m_pMemory, idx)) SharedFrameSlot{ 0 };
+		}
+		m_StaleRects.assign(slotCount, ScreenRect{ 0, 0, width, height });
+	}
+
+	SharedFrameRingWriter::~SharedFrameRingWriter()
+	{
+		if (!m_pMemory)
+		{
+			return;
+		}
+
+		CloseMapping(m_pMemory, m_Size, m_Handle);
+#ifndef _WIN32
+		// Windows drops the mapping with its last handle, readers that still have it open keep it alive on both
+		shm_unlink(("/" + m_Name).c_str());
+#endif
+	}
+
+	void SharedFrameRingWriter::Publish(const RenderTarget& renderTarget, const ScreenRect& dirtyRect)
+	{
+		if (!m_pMemory)
+		{
+			return;
+		}
+
+		SharedFrameRingHeader& header{ *GetHeader(m_pMemory) };
+		if (renderTarget.GetWidth() != header.width || renderTarget.GetHeight() != header.height)
+		{
+			return;
+		}
+
+		const uint64_t frame{ ++m_FrameCount };
+		const int slotIdx{ int(frame % header.slotCount) };
+		for (ScreenRect& staleRect : m_StaleRects)
+		{
+			staleRect.Merge(dirtyRect);
+		}
+
+		SharedFrameSlot& slot{ *GetSlot(m_pMemory, slotIdx) };
+		slot.sequence.store(frame * 2 - 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		const ScreenRect& staleRect{ m_StaleRects[slotIdx] };
+		uint32_t* pPixels{ GetPixels(m_pMemory, slotIdx) };
+		for (int y{ staleRect.minY }; y < staleRect.maxY; ++y)
+		{
+			std::copy(renderTarget.GetRow(y) + staleRect.minX, renderTarget.GetRow(y) + staleRect.maxX, pPixels + size_t(y) * header.stride + staleRect.minX);
+		}
+		m_StaleRects[slotIdx] = {};
+
+		slot.sequence.store(frame * 2, std::memory_order_release);
+		header.latestFrame.store(frame, std::memory_order_release);
+	}
+
+	SharedFrameRingReader::SharedFrameRingReader(const std::string& name)
+	{
+		m_pMemory = OpenMapping(name, m_Size, m_Handle);
+		if (!m_pMemory)
+		{
+			return;
+		}
+
+		// the header comes from another process, the sizes are checked before anything is computed from them
+		const SharedFrameRingHeader& header{ *GetHeader(m_pMemory) };
+		if (m_Size < sizeof(SharedFrameRingHeader) || header.magic != SharedFrameRingHeader::MAGIC || header.version != SharedFrameRingHeader::VERSION
+			|| header.slotCount < 1 || header.width <= 0 || header.height <= 0 || header.stride < header.width
+			|| m_Size < GetPixelOffset(header.slotCount) + GetFrameSize(header) * header.slotCount)
+		{
+			CloseMapping(m_pMemory, m_Size, m_Handle);
+			m_pMemory = nullptr;
+		}
+	}
+
+	SharedFrameRingReader::~SharedFrameRingReader()
+	{
+		if (m_pMemory)
+		{
+			CloseMapping(m_pMemory, m_Size, m_Handle);
+		}
+	}
+
+	int SharedFrameRingReader::GetWidth() const
+	{
+		return GetHeader(m_pMemory)->width;
+	}
+
+	int SharedFrameRingReader::GetHeight() const
+	{
+		return GetHeader(m_pMemory)->height;
+	}
+
+	int SharedFrameRingReader::GetStride() const
+	{
+		return GetHeader(m_pMemory)->stride;
+	}
+
+	bool SharedFrameRingReader::ReadLatest(uint64_t& frame, const std::function<void(const uint32_t* pPixels)>& read) const
+	{
+		if (!m_pMemory)
+		{
+			return false;
+		}
+
+		const SharedFrameRingHeader& header{ *GetHeader(m_pMemory) };
+		const uint64_t latestFrame{ header.latestFrame.load(std::memory_order_acquire) };
+		if (latestFrame == 0 || latestFrame == frame)
+		{
+			return false;
+		}
+
+		const int slotIdx{ int(latestFrame % header.slotCount) };
+		const SharedFrameSlot& slot{ *GetSlot(m_pMemory, slotIdx) };
+		const uint64_t sequence{ slot.sequence.load(std::memory_order_acquire) };
+		if (sequence != latestFrame * 2)
+		{
+			return false;
+		}
+
+		read(GetPixels(m_pMemory, slotIdx));
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.sequence.load(std::memory_order_relaxed) != sequence)
+		{
+			return false;
+		}
+
+		frame = latestFrame;
+		return true;
+	}
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+//Standard includes
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "RenderTarget.h"
+
+namespace dae
+{
+	// Layout of the shared memory, for consumers that don't link this library. Everything is little endian.
+	//   0                   SharedFrameRingHeader
+	//   64 + 64 * slot      SharedFrameSlot of every slot
+	//   GetPixelOffset()    slotCount frames of height rows of stride XRGB pixels
+	// Frame f (1, 2, ...) goes to slot f % slotCount. The slot's sequence is 2f - 1 while it is written and 2f when it is
+	// done, after which latestFrame becomes f. A reader picks latestFrame, checks the slot's sequence is 2f, reads the
+	// pixels and checks the sequence again; if it changed, the writer lapped the reader and the pixels are torn.
+	struct SharedFrameRingHeader
+	{
+		static constexpr uint32_t MAGIC{ 0x46454144 }; // "DAEF"
+		static constexpr uint32_t VERSION{ 1 };
+
+		uint32_t magic;
+		uint32_t version;
+		int32_t width;
+		int32_t height;
+		// pixels per row
+		int32_t stride;
+		int32_t slotCount;
+		std::atomic<uint64_t> latestFrame;
+	};
+
+	struct SharedFrameSlot
+	{
+		std::atomic<uint64_t> sequence;
+	};
+
+	static_assert(std::atomic<uint64_t>::is_always_lock_free, "the ring is shared between processes, its counters can't use locks");
+
+	// Publishes finished frames into a named shared memory ring. Publish only copies the rectangles the target slot
+	// missed and never waits on readers, a reader that is too slow notices it from the sequence counters instead.
+	class SharedFrameRingWriter final
+	{
+	public:
+		// name without prefix, it becomes Local\name on Windows and /name for shm_open elsewhere
+		SharedFrameRingWriter(const std::string& name, int width, int height, int slotCount = 3);
+		~SharedFrameRingWriter();
+
+		SharedFrameRingWriter(const SharedFrameRingWriter&) = delete;
+		SharedFrameRingWriter(SharedFrameRingWriter&&) noexcept = delete;
+		SharedFrameRingWriter& operator=(const SharedFrameRingWriter&) = delete;
+		SharedFrameRingWriter& operator=(SharedFrameRingWriter&&) noexcept = delete;
+
+		bool IsOpen() const { return m_pMemory != nullptr; };
+
+		// dirtyRect is what changed since the previous published frame
+		void Publish(const RenderTarget& renderTarget, const ScreenRect& dirtyRect);
+
+		uint64_t GetFramesPublished() const { return m_FrameCount; };
+
+	private:
+		std::string m_Name;
+		intptr_t m_Handle{ -1 };
+		void* m_pMemory{ nullptr };
+		size_t m_Size{};
+
+		uint64_t m_FrameCount{};
+		// changed since the slot was last written, only known to the writer
+		std::vector<ScreenRect> m_StaleRects{};
+	};
+
+	class SharedFrameRingReader final
+	{
+	public:
+		explicit SharedFrameRingReader(const std::string& name);
+		~SharedFrameRingReader();
+
+		SharedFrameRingReader(const SharedFrameRingReader&) = delete;
+		SharedFrameRingReader(SharedFrameRingReader&&) noexcept = delete;
+		SharedFrameRingReader& operator=(const SharedFrameRingReader&) = delete;
+		SharedFrameRingReader& operator=(SharedFrameRingReader&&) noexcept = delete;
+
+		bool IsOpen() const { return m_pMemory != nullptr; };
+		int GetWidth() const;
+		int GetHeight() const;
+		int GetStride() const;
+
+		// Calls read with the newest frame's pixels in place when it is newer than frame. Returns false when there is
+		// no newer frame or the writer overwrote it during read, whatever read made of the pixels must then be dropped.
+		bool ReadLatest(uint64_t& frame, const std::function<void(const uint32_t* pPixels)>& read) const;
+
+	private:
+		intptr_t m_Handle{ -1 };
+		void* m_pMemory{ nullptr };
+		size_t m_Size{};
+	};
+}
@@ -15,6 +15,9 @@ namespace dae
 		static Texture* LoadFromFile(const std::string& path);
 		ColorRGB Sample(const Vector2& uv) const;
 
+		int GetWidth() const { return m_pSurface->w; };
+		int GetHeight() const { return m_pSurface->h; };
+
 	private:
 		Texture(SDL_Surface* pSurface);
 
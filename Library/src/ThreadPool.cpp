@@ -0,0 +1,115 @@
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <memory>
+
+namespace dae
+{
+	ThreadPool::ThreadPool(unsigned int workerCount)
+	{
+		m_Workers.reserve(workerCount);
+		for (unsigned int idx{}; idx < workerCount; ++idx)
+		{
+			m_Workers.emplace_back(&ThreadPool::WorkerLoop, this);
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard lock{ m_Mutex };
+			m_IsStopping = true;
+		}
+		m_JobAvailable.notify_all();
+
+		for (std::thread& worker : m_Workers)
+		{
+			worker.join();
+		}
+	}
+
+	void ThreadPool::ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& task)
+	{
+		if (count == 0) return;
+		grainSize = std::max(grainSize, size_t{ 1 });
+
+		const size_t chunkCount{ (count + grainSize - 1) / grainSize };
+		if (chunkCount == 1 || m_Workers.empty())
+		{
+			task(0, count);
+			return;
+		}
+
+		// shared so helpers that start after the caller returned still find valid (exhausted) state
+		struct State
+		{
+			std::atomic<size_t> nextChunk{};
+			std::atomic<size_t> finishedChunks{};
+			std::mutex mutex{};
+			std::condition_variable finished{};
+		};
+		const auto pState{ std::make_shared<State>() };
+
+		const auto runChunks{ [pState, &task, count, grainSize, chunkCount]()
+			{
+				size_t chunk{};
+				while ((chunk = pState->nextChunk.fetch_add(1)) < chunkCount)
+				{
+					const size_t begin{ chunk * grainSize };
+					task(begin, std::min(begin + grainSize, count));
+
+					if (pState->finishedChunks.fetch_add(1) + 1 == chunkCount)
+					{
+						std::lock_guard lock{ pState->mutex };
+						pState->finished.notify_all();
+					}
+				}
+			} };
+
+		const size_t helperCount{ std::min(chunkCount - 1, m_Workers.size()) };
+		{
+			std::lock_guard lock{ m_Mutex };
+			for (size_t idx{}; idx < helperCount; ++idx)
+			{
+				m_Jobs.emplace_back(runChunks);
+			}
+		}
+		m_JobAvailable.notify_all();
+
+		runChunks();
+
+		std::unique_lock lock{ pState->mutex };
+		pState->finished.wait(lock, [&pState, chunkCount]() { return pState->finishedChunks.load() == chunkCount; });
+	}
+
+	std::future<void> ThreadPool::Enqueue(std::function<void()> job)
+	{
+		const auto pTask{ std::make_shared<std::packaged_task<void()>>(std::move(job)) };
+		std::future<void> result{ pTask->get_future() };
+
+		{
+			std::lock_guard lock{ m_Mutex };
+			m_Jobs.emplace_back([pTask]() { (*pTask)(); });
+		}
+		m_JobAvailable.notify_one();
+
+		return result;
+	}
+
+	void ThreadPool::WorkerLoop()
+	{
+		while (true)
+		{
+			std::function<void()> job{};
+			{
+				std::unique_lock lock{ m_Mutex };
+				m_JobAvailable.wait(lock, [this]() { return m_IsStopping || !m_Jobs.empty(); });
+				if (m_IsStopping && m_Jobs.empty()) return;
+
+				job = std::move(m_Jobs.front());
+				m_Jobs.pop_front();
+			}
+			job();
+		}
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+//Standard includes
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dae
+{
+	class ThreadPool final
+	{
+	public:
+		// the calling thread helps out in ParallelFor, so one worker less than the hardware threads by default
+		explicit ThreadPool(unsigned int workerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool(ThreadPool&&) noexcept = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		ThreadPool& operator=(ThreadPool&&) noexcept = delete;
+
+		// Calls task(begin, end) for chunks of at most grainSize items and blocks until every chunk is done
+		void ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& task);
+
+		std::future<void> Enqueue(std::function<void()> job);
+
+		unsigned int GetWorkerCount() const { return static_cast<unsigned int>(m_Workers.size()); };
+
+	private:
+		void WorkerLoop();
+
+		std::vector<std::thread> m_Workers{};
+		std::deque<std::function<void()>> m_Jobs{};
+		std::mutex m_Mutex{};
+		std::condition_variable m_JobAvailable{};
+		bool m_IsStopping{ false };
+	};
+}
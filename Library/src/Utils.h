@@ -169,6 +169,31 @@ namespace dae
 			return true;
 #endif
 		}
+
+		static void CalculateBounds(Mesh& mesh)
+		{
+			if (mesh.vertices.empty())
+			{
+				mesh.boundingBox = {};
+				mesh.boundingSphere = {};
+				return;
+			}
+
+			mesh.boundingBox = { mesh.vertices[0].position, mesh.vertices[0].position };
+			for (const Vertex& vertex : mesh.vertices)
+			{
+				mesh.boundingBox.min = { std::min(mesh.boundingBox.min.x, vertex.position.x), std::min(mesh.boundingBox.min.y, vertex.position.y), std::min(mesh.boundingBox.min.z, vertex.position.z) };
+				mesh.boundingBox.max = { std::max(mesh.boundingBox.max.x, vertex.position.x), std::max(mesh.boundingBox.max.y, vertex.position.y), std::max(mesh.boundingBox.max.z, vertex.position.z) };
+			}
+
+			// centered on the box, tighter spheres are not worth the load time here
+			mesh.boundingSphere.center = (mesh.boundingBox.min + mesh.boundingBox.max) * 0.5f;
+			mesh.boundingSphere.radius = 0.f;
+			for (const Vertex& vertex : mesh.vertices)
+			{
+				mesh.boundingSphere.radius = std::max(mesh.boundingSphere.radius, (vertex.position - mesh.boundingSphere.center).Magnitude());
+			}
+		}
 #pragma warning(pop)
 	}
 }
\ No newline at end of file
@@ -0,0 +1,82 @@
+#include "Microbenchmark.h"
+#include "Profiler.h"
+
+//Standard includes
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+namespace dae
+{
+	MicrobenchmarkState::Iterator MicrobenchmarkState::begin()
+	{
+		m_Begin = Profiler::Now();
+		return Iterator{ m_Iterations, this };
+	}
+
+	void MicrobenchmarkState::Stop()
+	{
+		m_End = Profiler::Now();
+	}
+
+	double MicrobenchmarkState::GetElapsedSeconds() const
+	{
+		return Profiler::ToMilliseconds(m_End - m_Begin) / 1000.0;
+	}
+
+	std::vector<Microbenchmark::Entry>& Microbenchmark::GetEntries()
+	{
+		static std::vector<Entry> entries{};
+		return entries;
+	}
+
+	bool Microbenchmark::Register(const char* name, Function function)
+	{
+		GetEntries().push_back(Entry{ name, std::move(function) });
+		return true;
+	}
+
+	int Microbenchmark::RunAll(const std::string& filter, double minSeconds)
+	{
+		std::cout << std::left << std::setw(40) << "Benchmark" << std::right << std::setw(14) << "ns/op"
+			<< std::setw(14) << "iterations" << std::setw(14) << "MB/s" << std::endl;
+		std::cout << std::string(82, '-') << std::endl;
+
+		int ranCount{};
+		for (const Entry& entry : GetEntries())
+		{
+			if (std::string{ entry.name }.find(filter) == std::string::npos)
+			{
+				continue;
+			}
+
+			// grow the iteration count until one run takes long enough to time reliably
+			size_t iterations{ 1 };
+			while (true)
+			{
+				MicrobenchmarkState state{ iterations };
+				entry.function(state);
+
+				const double elapsed{ state.GetElapsedSeconds() };
+				if (elapsed >= minSeconds || iterations >= size_t{ 1 } << 40)
+				{
+					const double items{ double(state.GetIterations()) * double(state.GetItemsPerIteration()) };
+					std::cout << std::left << std::setw(40) << entry.name << std::right << std::fixed << std::setprecision(2)
+						<< std::setw(14) << elapsed * 1e9 / items << std::setw(14) << state.GetIterations();
+					if (state.GetBytesPerIteration() > 0)
+					{
+						std::cout << std::setw(14) << double(state.GetBytesPerIteration()) * double(state.GetIterations()) / elapsed / 1e6;
+					}
+					std::cout << std::defaultfloat << std::endl;
+					break;
+				}
+
+				// aim a bit past minSeconds, but never grow more than 10x at once
+				const double scale{ elapsed > 0.0 ? minSeconds * 1.4 / elapsed : 10.0 };
+				iterations = std::max(iterations + 1, size_t(double(iterations) * std::min(scale, 10.0)));
+			}
+			++ranCount;
+		}
+		return ranCount;
+	}
+}
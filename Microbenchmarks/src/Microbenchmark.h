@@ -0,0 +1,101 @@
+#pragma once
+
+//Standard includes
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace dae
+{
+	// Loop state handed to every benchmark, used like Google Benchmark's: for (auto _ : state) { ... }
+	class MicrobenchmarkState final
+	{
+	public:
+		explicit MicrobenchmarkState(size_t iterations) : m_Iterations{ iterations } {};
+
+		// non-trivial so the unused loop variable doesn't warn
+		struct Value
+		{
+			~Value() {};
+		};
+
+		struct Iterator
+		{
+			size_t remaining;
+			MicrobenchmarkState* pState;
+
+			// the comparison that ends the loop stops the timer
+			bool operator!=(const Iterator&)
+			{
+				if (remaining != 0) return true;
+				pState->Stop();
+				return false;
+			};
+			void operator++() { --remaining; };
+			Value operator*() const { return Value{}; };
+		};
+
+		// the timer runs from begin() until the loop ends
+		Iterator begin();
+		Iterator end() { return Iterator{ 0, this }; };
+
+		// per iteration, ns/op is reported per item so batched benchmarks stay comparable
+		void SetItemsPerIteration(size_t items) { m_ItemsPerIteration = items; };
+		void SetBytesPerIteration(size_t bytes) { m_BytesPerIteration = bytes; };
+
+		size_t GetIterations() const { return m_Iterations; };
+		size_t GetItemsPerIteration() const { return m_ItemsPerIteration; };
+		size_t GetBytesPerIteration() const { return m_BytesPerIteration; };
+		double GetElapsedSeconds() const;
+
+	private:
+		void Stop();
+
+		size_t m_Iterations;
+		size_t m_ItemsPerIteration{ 1 };
+		size_t m_BytesPerIteration{};
+		uint64_t m_Begin{};
+		uint64_t m_End{};
+	};
+
+	class Microbenchmark final
+	{
+	public:
+		using Function = std::function<void(MicrobenchmarkState&)>;
+
+		static bool Register(const char* name, Function function);
+		// runs every benchmark whose name contains filter, each for at least minSeconds
+		static int RunAll(const std::string& filter, double minSeconds);
+
+	private:
+		struct Entry
+		{
+			const char* name;
+			Function function;
+		};
+		static std::vector<Entry>& GetEntries();
+	};
+
+	// keeps the compiler from discarding a result that is otherwise never read
+	template<typename T>
+	inline void DoNotOptimize(const T& value)
+	{
+#if defined(_MSC_VER)
+		static const void* volatile pSink{};
+		pSink = &value;
+		_ReadWriteBarrier();
+#else
+		asm volatile("" : : "r,m"(value) : "memory");
+#endif
+	}
+}
+
+#define MICROBENCHMARK(name) \
+	static void name(dae::MicrobenchmarkState& state); \
+	static const bool name##_isRegistered{ dae::Microbenchmark::Register(#name, name) }; \
+	static void name(dae::MicrobenchmarkState& state)
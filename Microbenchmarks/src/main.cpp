@@ -0,0 +1,246 @@
+//Standard includes
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <random>
+
+//Project includes
+#include "Microbenchmark.h"
+#include "DataTypes.h"
+#include "Renderer.h"
+#include "Texture.h"
+#include "Utils.h"
+
+using namespace dae;
+
+namespace
+{
+	const char* const MESH_PATH{ "Resources/vehicle.obj" };
+	const char* const TEXTURE_PATH{ "Resources/vehicle_diffuse.png" };
+
+	// inputs per iteration, large enough to amortize the loop and small enough to stay in cache like a triangle's pixels do
+	constexpr size_t BATCH_SIZE{ 1024 };
+
+	// the vehicle as the renderer sees it from the start position, every input below is taken from it
+	struct BenchmarkScene
+	{
+		MemoryRenderTarget renderTarget{ 640, 480 };
+		Renderer renderer{ &renderTarget };
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		// three screen space vertices per triangle, like CreateOrderedVertices outputs
+		std::vector<Vertex_Out> orderedVertices{};
+
+		// pixels inside the bounding boxes of on-screen triangles, with the triangle they were picked for
+		std::vector<Vector2> pixels{};
+		std::vector<int> pixelTriangles{};
+		// normalized weights of pixels that are covered
+		std::vector<std::array<float, 3>> coveredWeights{};
+		std::vector<int> coveredTriangles{};
+		std::vector<Vertex_Out> interpolatedVertices{};
+
+		BenchmarkScene()
+		{
+			Utils::ParseOBJ(MESH_PATH, vertices, indices);
+			renderer.Update(0.f);
+
+			const Camera& camera{ renderer.GetCamera() };
+			const Matrix worldViewProjection{ camera.viewMatrix * camera.projectionMatrix };
+			std::vector<Vertex_Out> verticesOut(vertices.size());
+			renderer.TransformVertices(vertices, verticesOut, Matrix{}, worldViewProjection);
+			for (uint32_t index : indices) orderedVertices.push_back(verticesOut[index]);
+
+			std::mt19937 generator{ 42 };
+			std::uniform_real_distribution<float> distribution{ 0.f, 1.f };
+			std::vector<float> weights(3);
+			const int triangleCount{ int(orderedVertices.size() / 3) };
+			for (int attempt{}; attempt < int(BATCH_SIZE) * 64 && pixels.size() < BATCH_SIZE; ++attempt)
+			{
+				const int triangle{ std::uniform_int_distribution<int>{ 0, std::max(triangleCount - 1, 0) }(generator) * 3 };
+				if (triangleCount == 0 || renderer.IsOutsideFrustum(orderedVertices[triangle], orderedVertices[triangle + 1], orderedVertices[triangle + 2])) continue;
+
+				Vector2 min{ FLT_MAX, FLT_MAX }, max{ -FLT_MAX, -FLT_MAX };
+				for (int corner{}; corner < 3; ++corner)
+				{
+					min.x = std::min(min.x, orderedVertices[triangle + corner].position.x);
+					min.y = std::min(min.y, orderedVertices[triangle + corner].position.y);
+					max.x = std::max(max.x, orderedVertices[triangle + corner].position.x);
+					max.y = std::max(max.y, orderedVertices[triangle + corner].position.y);
+				}
+				const Vector2 pixel{ Lerpf(min.x, max.x, distribution(generator)), Lerpf(min.y, max.y, distribution(generator)) };
+				pixels.push_back(pixel);
+				pixelTriangles.push_back(triangle);
+
+				if (renderer.IsPixelInTriangle(orderedVertices, pixel, weights, triangle))
+				{
+					const float area{ weights[0] + weights[1] + weights[2] };
+					coveredWeights.push_back({ weights[0] / area, weights[1] / area, weights[2] / area });
+					coveredTriangles.push_back(triangle);
+					interpolatedVertices.push_back(renderer.InterpolatedVertexAtrributes(orderedVertices[triangle], orderedVertices[triangle + 1], orderedVertices[triangle + 2],
+						{ weights[0] / area, weights[1] / area, weights[2] / area }));
+				}
+			}
+		}
+	};
+
+	BenchmarkScene& GetScene()
+	{
+		static BenchmarkScene scene{};
+		return scene;
+	}
+}
+
+MICROBENCHMARK(Texture_Sample)
+{
+	Texture* pTexture{ Texture::LoadFromFile(TEXTURE_PATH) };
+
+	std::mt19937 generator{ 42 };
+	std::uniform_real_distribution<float> distribution{ 0.f, 0.999f };
+	std::vector<Vector2> uvs(BATCH_SIZE);
+	for (Vector2& uv : uvs) uv = { distribution(generator), distribution(generator) };
+
+	for (auto _ : state)
+	{
+		for (const Vector2& uv : uvs) DoNotOptimize(pTexture->Sample(uv));
+	}
+	state.SetItemsPerIteration(BATCH_SIZE);
+	// one 32 bit texel read per sample
+	state.SetBytesPerIteration(BATCH_SIZE * sizeof(uint32_t));
+
+	delete pTexture;
+}
+
+MICROBENCHMARK(Matrix_TransformPoint)
+{
+	const Camera& camera{ GetScene().renderer.GetCamera() };
+	const Matrix worldViewProjection{ camera.viewMatrix * camera.projectionMatrix };
+
+	std::vector<Vector4> points(BATCH_SIZE);
+	for (size_t idx{}; idx < points.size(); ++idx) points[idx] = Vector4{ GetScene().vertices[idx % GetScene().vertices.size()].position, 1.f };
+
+	for (auto _ : state)
+	{
+		for (const Vector4& point : points) DoNotOptimize(worldViewProjection.TransformPoint(point));
+	}
+	state.SetItemsPerIteration(BATCH_SIZE);
+	state.SetBytesPerIteration(BATCH_SIZE * sizeof(Vector4) * 2);
+}
+
+MICROBENCHMARK(Matrix_TransformPoints_Batched)
+{
+	const Camera& camera{ GetScene().renderer.GetCamera() };
+	const Matrix worldViewProjection{ camera.viewMatrix * camera.projectionMatrix };
+
+	std::vector<Vector3> points(BATCH_SIZE);
+	std::vector<Vector4> pointsOut(BATCH_SIZE);
+	for (size_t idx{}; idx < points.size(); ++idx) points[idx] = GetScene().vertices[idx % GetScene().vertices.size()].position;
+
+	for (auto _ : state)
+	{
+		worldViewProjection.TransformPoints(std::span<const Vector3>{ points }, std::span<Vector4>{ pointsOut }, true);
+		DoNotOptimize(pointsOut[0]);
+	}
+	state.SetItemsPerIteration(BATCH_SIZE);
+	state.SetBytesPerIteration(BATCH_SIZE * (sizeof(Vector3) + sizeof(Vector4)));
+}
+
+MICROBENCHMARK(Renderer_IsPixelInTriangle)
+{
+	BenchmarkScene& scene{ GetScene() };
+	std::vector<float> weights(3);
+
+	for (auto _ : state)
+	{
+		for (size_t idx{}; idx < scene.pixels.size(); ++idx)
+		{
+			DoNotOptimize(scene.renderer.IsPixelInTriangle(scene.orderedVertices, scene.pixels[idx], weights, scene.pixelTriangles[idx]));
+		}
+	}
+	state.SetItemsPerIteration(std::max(scene.pixels.size(), size_t{ 1 }));
+}
+
+MICROBENCHMARK(Renderer_InterpolatedVertexAtrributes)
+{
+	BenchmarkScene& scene{ GetScene() };
+	std::vector<float> weights(3);
+
+	for (auto _ : state)
+	{
+		for (size_t idx{}; idx < scene.coveredWeights.size(); ++idx)
+		{
+			const int triangle{ scene.coveredTriangles[idx] };
+			weights.assign(scene.coveredWeights[idx].begin(), scene.coveredWeights[idx].end());
+			DoNotOptimize(scene.renderer.InterpolatedVertexAtrributes(scene.orderedVertices[triangle], scene.orderedVertices[triangle + 1], scene.orderedVertices[triangle + 2], weights));
+		}
+	}
+	state.SetItemsPerIteration(std::max(scene.coveredWeights.size(), size_t{ 1 }));
+}
+
+MICROBENCHMARK(Renderer_PixelShading)
+{
+	BenchmarkScene& scene{ GetScene() };
+
+	for (auto _ : state)
+	{
+		for (const Vertex_Out& vertex : scene.interpolatedVertices) DoNotOptimize(scene.renderer.PixelShading(vertex));
+	}
+	state.SetItemsPerIteration(std::max(scene.interpolatedVertices.size(), size_t{ 1 }));
+}
+
+MICROBENCHMARK(Renderer_PixelShadingCached)
+{
+	BenchmarkScene& scene{ GetScene() };
+
+	// nothing invalidates the cache of mesh 0 in between, so only the first iteration fills it
+	for (auto _ : state)
+	{
+		for (const Vertex_Out& vertex : scene.interpolatedVertices) DoNotOptimize(scene.renderer.PixelShadingCached(vertex, 0));
+	}
+	state.SetItemsPerIteration(std::max(scene.interpolatedVertices.size(), size_t{ 1 }));
+}
+
+MICROBENCHMARK(Utils_ParseOBJ)
+{
+	std::vector<Vertex> vertices{};
+	std::vector<uint32_t> indices{};
+
+	for (auto _ : state)
+	{
+		vertices.clear();
+		indices.clear();
+		Utils::ParseOBJ(MESH_PATH, vertices, indices);
+		DoNotOptimize(vertices.data());
+	}
+	state.SetBytesPerIteration(size_t(std::filesystem::file_size(MESH_PATH)));
+}
+
+// usage: Microbenchmarks [name filter] [--min-time seconds]
+int main(int argc, char* args[])
+{
+	std::string filter{};
+	double minSeconds{ 0.5 };
+	for (int idx = 1; idx < argc; ++idx)
+	{
+		if (strcmp(args[idx], "--min-time") == 0 && idx + 1 < argc)
+			minSeconds = atof(args[++idx]);
+		else
+			filter = args[idx];
+	}
+
+	if (!std::filesystem::exists(MESH_PATH) || !std::filesystem::exists(TEXTURE_PATH) || GetScene().interpolatedVertices.empty())
+	{
+		std::cerr << "Could not build benchmark inputs from " << MESH_PATH << std::endl;
+		return 1;
+	}
+
+	if (Microbenchmark::RunAll(filter, minSeconds) == 0)
+	{
+		std::cerr << "No benchmark matches " << filter << std::endl;
+		return 1;
+	}
+	return 0;
+}
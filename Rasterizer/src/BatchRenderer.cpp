@@ -0,0 +1,129 @@
+//Standard includes
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+//Project includes
+#include "BatchRenderer.h"
+#include "ImageWriter.h"
+#include "Profiler.h"
+#include "Renderer.h"
+
+using namespace dae;
+
+bool BatchRenderer::LoadFramesFromFile(const std::string& path, std::vector<BatchFrame>& frames)
+{
+	std::ifstream file{ path };
+	if (!file)
+	{
+		return false;
+	}
+
+	std::vector<BatchFrame> loadedFrames{};
+	std::string line{};
+	while (std::getline(file, line))
+	{
+		if (line.empty() || line[0] == '#')
+		{
+			continue;
+		}
+
+		std::istringstream stream{ line };
+		BatchFrame frame{};
+		float yaw{};
+		if (!(stream >> frame.cameraOrigin.x >> frame.cameraOrigin.y >> frame.cameraOrigin.z
+			>> frame.cameraTarget.x >> frame.cameraTarget.y >> frame.cameraTarget.z >> yaw))
+		{
+			return false;
+		}
+
+		// the translation is optional
+		Vector3 translation{};
+		stream >> translation.x >> translation.y >> translation.z;
+		frame.meshWorldMatrix = Matrix::CreateRotationY(yaw * TO_RADIANS) * Matrix::CreateTranslation(translation);
+		loadedFrames.push_back(frame);
+	}
+
+	if (loadedFrames.empty())
+	{
+		return false;
+	}
+
+	frames = std::move(loadedFrames);
+	return true;
+}
+
+std::vector<BatchFrame> BatchRenderer::CreateTurntable(int frameCount)
+{
+	std::vector<BatchFrame> frames(std::max(frameCount, 0));
+	for (int idx{}; idx < int(frames.size()); ++idx)
+	{
+		frames[idx].meshWorldMatrix = Matrix::CreateRotationY(idx * PI_2 / frames.size());
+	}
+	return frames;
+}
+
+BatchResult BatchRenderer::Run(const RendererResources* pResources, int width, int height, const std::vector<BatchFrame>& frames, const BatchOptions& options)
+{
+	BatchResult result{};
+	result.jobCount = options.jobCount > 0 ? options.jobCount : int(std::max(std::thread::hardware_concurrency(), 1u));
+	result.jobCount = std::min(result.jobCount, std::max(int(frames.size()), 1));
+
+	std::error_code error{};
+	std::filesystem::create_directories(options.outputDirectory, error);
+
+	std::atomic<int> nextFrame{ 0 };
+	std::atomic<int> framesRendered{ 0 };
+	std::atomic<int> framesFailed{ 0 };
+	std::atomic<size_t> trianglesRasterized{ 0 };
+
+	const auto renderFrames = [&]()
+	{
+		// one job per core already keeps the machine busy, so the vertex stage stays on this thread
+		MemoryRenderTarget renderTarget{ width, height };
+		Renderer renderer{ &renderTarget, pResources, 0 };
+		renderer.ToggleRotation();
+
+		for (int frameIdx{ nextFrame++ }; frameIdx < int(frames.size()); frameIdx = nextFrame++)
+		{
+			const BatchFrame& frame{ frames[frameIdx] };
+			renderer.GetCamera().LookAt(frame.cameraOrigin, frame.cameraTarget);
+			renderer.SetMeshWorldMatrix(0, frame.meshWorldMatrix);
+			renderer.Update(0.f);
+			renderer.Render();
+			trianglesRasterized += renderer.GetFrameStatistics().trianglesRasterized;
+
+			char fileName[32]{};
+			snprintf(fileName, sizeof(fileName), "frame_%05d.", frameIdx);
+			if (ImageWriter::Write(renderTarget, (std::filesystem::path{ options.outputDirectory } / (fileName + options.fileExtension)).string()))
+				++framesRendered;
+			else
+				++framesFailed;
+		}
+	};
+
+	const uint64_t start{ Profiler::Now() };
+	std::vector<std::thread> jobs{};
+	for (int idx{ 1 }; idx < result.jobCount; ++idx)
+	{
+		jobs.emplace_back(renderFrames);
+	}
+	renderFrames();
+	for (std::thread& job : jobs)
+	{
+		job.join();
+	}
+	result.seconds = Profiler::ToMilliseconds(Profiler::Now() - start) / 1000.0;
+
+	// nothing records zones anymore, so the per thread buffers can be emptied
+	Profiler::Get().EndFrame();
+
+	result.framesRendered = framesRendered;
+	result.framesFailed = framesFailed;
+	result.trianglesRasterized = trianglesRasterized;
+	return result;
+}
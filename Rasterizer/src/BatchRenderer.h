@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Maths.h"
+
+namespace dae
+{
+	class RendererResources;
+
+	// everything that differs between two frames of a sequence
+	struct BatchFrame
+	{
+		Vector3 cameraOrigin{ 0.f, 5.f, -64.f };
+		Vector3 cameraTarget{ 0.f, 5.f, 0.f };
+		Matrix meshWorldMatrix{};
+	};
+
+	struct BatchOptions
+	{
+		std::string outputDirectory{ "Frames" };
+		// frames rendered at the same time, each by its own renderer, 0 uses one per hardware thread
+		int jobCount{ 0 };
+		// picks the encoder, see ImageWriter
+		std::string fileExtension{ "bmp" };
+	};
+
+	struct BatchResult
+	{
+		int framesRendered{};
+		int framesFailed{};
+		// summed over every frame, 0 means nothing was in view
+		size_t trianglesRasterized{};
+		int jobCount{};
+		double seconds{};
+	};
+
+	class BatchRenderer final
+	{
+	public:
+		// one frame per line: originX originY originZ targetX targetY targetZ yawDegrees [x y z], # starts a comment.
+		// yaw turns the vehicle around its up axis, x y z moves it afterwards
+		static bool LoadFramesFromFile(const std::string& path, std::vector<BatchFrame>& frames);
+		// the camera stays at the start position while the vehicle turns around once
+		static std::vector<BatchFrame> CreateTurntable(int frameCount);
+
+		// Renders every frame to outputDirectory/frame_00000.<fileExtension> and onwards. Frames are handed out to the jobs one at a
+		// time, every job owns its render target and renderer and only reads the shared resources.
+		static BatchResult Run(const RendererResources* pResources, int width, int height, const std::vector<BatchFrame>& frames, const BatchOptions& options);
+	};
+}
@@ -0,0 +1,235 @@
+//Standard includes
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <ostream>
+#include <sstream>
+
+//Project includes
+#include "Benchmark.h"
+#include "Profiler.h"
+#include "Renderer.h"
+
+using namespace dae;
+
+CameraPath::CameraPath(std::vector<CameraKeyframe> keyframes) :
+	m_Keyframes(std::move(keyframes))
+{
+	std::sort(m_Keyframes.begin(), m_Keyframes.end(), [](const CameraKeyframe& a, const CameraKeyframe& b) { return a.time < b.time; });
+}
+
+bool CameraPath::LoadFromFile(const std::string& path, CameraPath& cameraPath)
+{
+	std::ifstream file{ path };
+	if (!file)
+	{
+		return false;
+	}
+
+	std::vector<CameraKeyframe> keyframes{};
+	std::string line{};
+	while (std::getline(file, line))
+	{
+		if (line.empty() || line[0] == '#')
+		{
+			continue;
+		}
+
+		std::istringstream stream{ line };
+		CameraKeyframe keyframe{};
+		if (!(stream >> keyframe.time >> keyframe.origin.x >> keyframe.origin.y >> keyframe.origin.z
+			>> keyframe.target.x >> keyframe.target.y >> keyframe.target.z))
+		{
+			return false;
+		}
+		keyframes.push_back(keyframe);
+	}
+
+	if (keyframes.empty())
+	{
+		return false;
+	}
+
+	cameraPath = CameraPath{ std::move(keyframes) };
+	return true;
+}
+
+CameraPath CameraPath::CreateDefault()
+{
+	// starts at the interactive start position, the vehicle sits at the origin
+	const int keyframeCount{ 9 };
+	const float duration{ 10.f };
+	std::vector<CameraKeyframe> keyframes{};
+	for (int idx{}; idx < keyframeCount; ++idx)
+	{
+		const float alpha{ idx / float(keyframeCount - 1) };
+		const float angle{ alpha * PI_2 };
+		const float distance{ Lerpf(64.f, 30.f, sinf(alpha * PI)) };
+		keyframes.push_back(CameraKeyframe{ alpha * duration, { -sinf(angle) * distance, 5.f + 10.f * sinf(alpha * PI), -cosf(angle) * distance }, Vector3{ 0.f, 5.f, 0.f } });
+	}
+	return CameraPath{ std::move(keyframes) };
+}
+
+void CameraPath::Evaluate(float time, Vector3& origin, Vector3& target) const
+{
+	if (m_Keyframes.empty())
+	{
+		return;
+	}
+
+	const float duration{ GetDuration() };
+	if (duration > 0.f)
+	{
+		time = fmodf(time, duration);
+	}
+
+	const auto next{ std::upper_bound(m_Keyframes.begin(), m_Keyframes.end(), time, [](float t, const CameraKeyframe& keyframe) { return t < keyframe.time; }) };
+	if (next == m_Keyframes.begin() || next == m_Keyframes.end())
+	{
+		const CameraKeyframe& keyframe{ next == m_Keyframes.begin() ? m_Keyframes.front() : m_Keyframes.back() };
+		origin = keyframe.origin;
+		target = keyframe.target;
+		return;
+	}
+
+	const CameraKeyframe& previous{ *(next - 1) };
+	const float segment{ next->time - previous.time };
+	const float alpha{ segment > 0.f ? (time - previous.time) / segment : 0.f };
+	origin = previous.origin + (next->origin - previous.origin) * alpha;
+	target = previous.target + (next->target - previous.target) * alpha;
+}
+
+TimingSummary TimingSummary::FromSamples(std::vector<double> samples)
+{
+	TimingSummary summary{};
+	if (samples.empty())
+	{
+		return summary;
+	}
+
+	std::sort(samples.begin(), samples.end());
+
+	// nearest rank
+	const auto percentile{ [&samples](double p)
+		{
+			const size_t rank{ size_t(std::ceil(p * double(samples.size()))) };
+			return samples[std::clamp(rank, size_t{ 1 }, samples.size()) - 1];
+		} };
+
+	double total{};
+	for (double sample : samples) total += sample;
+
+	summary.mean = total / double(samples.size());
+	summary.p50 = percentile(0.50);
+	summary.p95 = percentile(0.95);
+	summary.p99 = percentile(0.99);
+	summary.min = samples.front();
+	summary.max = samples.back();
+	return summary;
+}
+
+BenchmarkResult Benchmark::Run(Renderer* pRenderer, const BenchmarkOptions& options)
+{
+	BenchmarkResult result{};
+	result.width = pRenderer->GetWidth();
+	result.height = pRenderer->GetHeight();
+	result.options = options;
+
+	std::vector<double> frameTimes{};
+	frameTimes.reserve(options.measuredFrames);
+	std::map<std::string, std::vector<double>> stageTimes{};
+	size_t triangles{};
+	size_t vertices{};
+
+	const int frameCount{ options.warmupFrames + options.measuredFrames };
+	for (int frameIdx{}; frameIdx < frameCount; ++frameIdx)
+	{
+		// the path is sampled by frame index, so every run renders the exact same frames
+		Vector3 origin{}, target{};
+		options.cameraPath.Evaluate(frameIdx * options.timeStep, origin, target);
+		pRenderer->GetCamera().LookAt(origin, target);
+
+		const uint64_t begin{ Profiler::Now() };
+		pRenderer->Update(options.timeStep);
+		pRenderer->Render();
+		const uint64_t end{ Profiler::Now() };
+		Profiler::Get().EndFrame();
+
+		const int measuredIdx{ frameIdx - options.warmupFrames };
+		if (measuredIdx < 0)
+		{
+			continue;
+		}
+
+		frameTimes.push_back(Profiler::ToMilliseconds(end - begin));
+		for (const auto& [name, milliseconds] : Profiler::Get().GetLastFrame())
+		{
+			// stages that didn't run in earlier measured frames count as 0 ms there
+			std::vector<double>& times{ stageTimes[name] };
+			times.resize(measuredIdx, 0.0);
+			times.push_back(milliseconds);
+		}
+
+		triangles += pRenderer->GetFrameStatistics().trianglesRasterized;
+		vertices += pRenderer->GetFrameStatistics().verticesTransformed;
+	}
+
+	result.frameTime = TimingSummary::FromSamples(frameTimes);
+	for (auto& [name, times] : stageTimes)
+	{
+		times.resize(frameTimes.size(), 0.0);
+		result.stages.emplace_back(name, TimingSummary::FromSamples(std::move(times)));
+	}
+	if (!frameTimes.empty())
+	{
+		result.trianglesRasterized = triangles / double(frameTimes.size());
+		result.verticesTransformed = vertices / double(frameTimes.size());
+	}
+	return result;
+}
+
+void BenchmarkResult::WriteJson(std::ostream& os) const
+{
+	const auto writeSummary{ [&os](const TimingSummary& summary)
+		{
+			os << "{ \"mean\": " << summary.mean << ", \"p50\": " << summary.p50 << ", \"p95\": " << summary.p95
+				<< ", \"p99\": " << summary.p99 << ", \"min\": " << summary.min << ", \"max\": " << summary.max << " }";
+		} };
+
+#ifdef DAE_USE_SSE
+	const bool isSimdEnabled{ true };
+#else
+	const bool isSimdEnabled{ false };
+#endif
+#ifndef DISABLE_PROFILER
+	const bool isProfilerEnabled{ true };
+#else
+	const bool isProfilerEnabled{ false };
+#endif
+
+	os << std::fixed << std::setprecision(4) << std::boolalpha;
+	os << "{\n";
+	os << "  \"width\": " << width << ",\n";
+	os << "  \"height\": " << height << ",\n";
+	os << "  \"warmupFrames\": " << options.warmupFrames << ",\n";
+	os << "  \"measuredFrames\": " << options.measuredFrames << ",\n";
+	os << "  \"timeStep\": " << options.timeStep << ",\n";
+	os << "  \"simd\": " << isSimdEnabled << ",\n";
+	os << "  \"profiler\": " << isProfilerEnabled << ",\n";
+	os << "  \"trianglesRasterized\": " << trianglesRasterized << ",\n";
+	os << "  \"verticesTransformed\": " << verticesTransformed << ",\n";
+	os << "  \"frameTimeMs\": ";
+	writeSummary(frameTime);
+	os << ",\n";
+	os << "  \"stageTimeMs\": {";
+	for (size_t idx{}; idx < stages.size(); ++idx)
+	{
+		os << (idx == 0 ? "\n" : ",\n") << "    \"" << stages[idx].first << "\": ";
+		writeSummary(stages[idx].second);
+	}
+	os << (stages.empty() ? "}\n" : "\n  }\n");
+	os << "}\n";
+	os << std::defaultfloat << std::noboolalpha;
+}
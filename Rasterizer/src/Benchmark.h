@@ -0,0 +1,80 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Maths.h"
+
+namespace dae
+{
+	class Renderer;
+
+	struct CameraKeyframe
+	{
+		float time{};
+		Vector3 origin{};
+		Vector3 target{};
+	};
+
+	// camera positions over time, linearly interpolated and looped
+	class CameraPath final
+	{
+	public:
+		CameraPath() = default;
+		explicit CameraPath(std::vector<CameraKeyframe> keyframes);
+
+		// one keyframe per line: time originX originY originZ targetX targetY targetZ, # starts a comment
+		static bool LoadFromFile(const std::string& path, CameraPath& cameraPath);
+		// circles the vehicle while moving closer and back out, used when no path file is given
+		static CameraPath CreateDefault();
+
+		void Evaluate(float time, Vector3& origin, Vector3& target) const;
+		float GetDuration() const { return m_Keyframes.empty() ? 0.f : m_Keyframes.back().time; };
+
+	private:
+		std::vector<CameraKeyframe> m_Keyframes{};
+	};
+
+	struct BenchmarkOptions
+	{
+		int warmupFrames{ 60 };
+		int measuredFrames{ 600 };
+		// every frame advances the scene by exactly this much, independent of how long it took
+		float timeStep{ 1.f / 60.f };
+		CameraPath cameraPath{ CameraPath::CreateDefault() };
+	};
+
+	struct TimingSummary
+	{
+		double mean{};
+		double p50{};
+		double p95{};
+		double p99{};
+		double min{};
+		double max{};
+
+		static TimingSummary FromSamples(std::vector<double> samples);
+	};
+
+	struct BenchmarkResult
+	{
+		int width{};
+		int height{};
+		BenchmarkOptions options{};
+		TimingSummary frameTime{};
+		std::vector<std::pair<std::string, TimingSummary>> stages{};
+		double trianglesRasterized{};
+		double verticesTransformed{};
+
+		void WriteJson(std::ostream& os) const;
+	};
+
+	class Benchmark final
+	{
+	public:
+		// renders warm-up and measured frames with a fixed time step, frame times are in milliseconds
+		static BenchmarkResult Run(Renderer* pRenderer, const BenchmarkOptions& options);
+	};
+}
@@ -1,34 +1,151 @@
-//External includes
-#include "SDL.h"
-#include "SDL_surface.h"
+//Standard includes
+#include <iostream>
 
 //Project includes
 #include "Renderer.h"
+#include "Frustum.h"
 #include "Maths.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "Profiler.h"
 #include "Texture.h"
+#include "ThreadPool.h"
 #include "Utils.h"
 
 using namespace dae;
 
-Renderer::Renderer(SDL_Window* pWindow) :
-	m_pWindow(pWindow)
+RendererResources::RendererResources(const MeshLoadOptions& meshLoadOptions)
+	: RendererResources{ LoadVehicleMeshes(), meshLoadOptions }
 {
-	//Initialize
-	SDL_GetWindowSize(pWindow, &m_Width, &m_Height);
-
-	//Create Buffers
-	m_pFrontBuffer = SDL_GetWindowSurface(pWindow);
-	m_pBackBuffer = SDL_CreateRGBSurface(0, m_Width, m_Height, 32, 0, 0, 0, 0);
-	m_pBackBufferPixels = (uint32_t*)m_pBackBuffer->pixels;
+}
 
-	m_pDepthBufferPixels = new float[m_Width * m_Height];
+RendererResources::RendererResources(std::vector<Mesh> meshes, const MeshLoadOptions& meshLoadOptions)
+	: m_Meshes{ std::move(meshes) }
+{
 	m_pDiffuseTexture = Texture::LoadFromFile("Resources/vehicle_diffuse.png");
 	m_pNormalTexture = Texture::LoadFromFile("Resources/vehicle_normal.png");
 	m_pSpecularTexture = Texture::LoadFromFile("Resources/vehicle_specular.png");
 	m_pGlossinessTexture = Texture::LoadFromFile("Resources/vehicle_gloss.png");
 
-	m_ObjectMeshes.push_back(Mesh{});
-	Utils::ParseOBJ("Resources/vehicle.obj", m_ObjectMeshes[0].vertices, m_ObjectMeshes[0].indices);
+	for (Mesh& mesh : m_Meshes)
+	{
+		if (meshLoadOptions.optimize)
+		{
+			const MeshOptimizationStats stats{ MeshOptimizer::OptimizeMesh(mesh) };
+			std::cout << "Mesh optimized: vertices " << stats.verticesBefore << " -> " << stats.verticesAfter
+				<< ", ACMR " << stats.acmrBefore << " -> " << stats.acmrAfter
+				<< ", overdraw " << stats.overdrawBefore << " -> " << stats.overdrawAfter << std::endl;
+		}
+		if (meshLoadOptions.buildLODs && mesh.primitiveTopology == PrimitiveTopology::TriangleList)
+		{
+			MeshSimplifier::BuildLODs(mesh);
+			for (MeshLOD& lod : mesh.lods)
+			{
+				if (meshLoadOptions.optimize) MeshOptimizer::OptimizeVertexCache(lod.indices, mesh.vertices.size());
+				std::cout << "LOD " << &lod - mesh.lods.data() + 1 << ": " << lod.indices.size() / 3 << " triangles, error " << lod.error << std::endl;
+			}
+		}
+		if (meshLoadOptions.buildMeshlets && mesh.primitiveTopology == PrimitiveTopology::TriangleList)
+		{
+			MeshOptimizer::BuildMeshlets(mesh);
+			std::cout << "Meshlets built: " << mesh.meshlets.size() << std::endl;
+		}
+
+		Utils::CalculateBounds(mesh);
+	}
+
+	BuildShadingDetail();
+}
+
+RendererResources::~RendererResources()
+{
+	delete m_pDiffuseTexture;
+	delete m_pNormalTexture;
+	delete m_pSpecularTexture;
+	delete m_pGlossinessTexture;
+}
+
+std::vector<Mesh> RendererResources::LoadVehicleMeshes()
+{
+	std::vector<Mesh> meshes(1);
+	Utils::ParseOBJ("Resources/vehicle.obj", meshes[0].vertices, meshes[0].indices);
+	return meshes;
+}
+
+float RendererResources::GetShadingDetail(const Vector2& uv) const
+{
+	if (m_ShadingDetail.empty())
+	{
+		return 0.f;
+	}
+
+	const int x{ Clamp(int(uv.x * DETAIL_GRID_SIZE), 0, DETAIL_GRID_SIZE - 1) };
+	const int y{ Clamp(int(uv.y * DETAIL_GRID_SIZE), 0, DETAIL_GRID_SIZE - 1) };
+	return m_ShadingDetail[x + y * DETAIL_GRID_SIZE];
+}
+
+void RendererResources::BuildShadingDetail()
+{
+	if (!m_pNormalTexture || !m_pDiffuseTexture)
+	{
+		return;
+	}
+
+	// standard deviation of the normal map and the diffuse brightness over samples spread across each tile
+	const int samplesPerSide{ 8 };
+	m_ShadingDetail.resize(DETAIL_GRID_SIZE * DETAIL_GRID_SIZE);
+	for (int tileY{}; tileY < DETAIL_GRID_SIZE; ++tileY)
+	{
+		for (int tileX{}; tileX < DETAIL_GRID_SIZE; ++tileX)
+		{
+			ColorRGB normalSum{}, normalSquaredSum{};
+			float brightnessSum{}, brightnessSquaredSum{};
+			for (int sample{}; sample < samplesPerSide * samplesPerSide; ++sample)
+			{
+				const Vector2 uv{ (tileX + (sample % samplesPerSide + 0.5f) / samplesPerSide) / DETAIL_GRID_SIZE,
+					(tileY + (sample / samplesPerSide + 0.5f) / samplesPerSide) / DETAIL_GRID_SIZE };
+				const ColorRGB normal{ m_pNormalTexture->Sample(uv) };
+				const ColorRGB diffuse{ m_pDiffuseTexture->Sample(uv) };
+				const float brightness{ (diffuse.r + diffuse.g + diffuse.b) / 3.f };
+
+				normalSum += normal;
+				normalSquaredSum += ColorRGB{ normal.r * normal.r, normal.g * normal.g, normal.b * normal.b };
+				brightnessSum += brightness;
+				brightnessSquaredSum += brightness * brightness;
+			}
+
+			const float count{ float(samplesPerSide * samplesPerSide) };
+			const float normalVariance{ (normalSquaredSum.r + normalSquaredSum.g + normalSquaredSum.b) / count
+				- (normalSum.r * normalSum.r + normalSum.g * normalSum.g + normalSum.b * normalSum.b) / (count * count) };
+			const float brightnessVariance{ brightnessSquaredSum / count - brightnessSum * brightnessSum / (count * count) };
+			m_ShadingDetail[tileX + tileY * DETAIL_GRID_SIZE] = std::sqrt(std::max(normalVariance, 0.f)) + std::sqrt(std::max(brightnessVariance, 0.f));
+		}
+	}
+}
+
+Renderer::Renderer(RenderTarget* pRenderTarget, const MeshLoadOptions& meshLoadOptions) :
+	Renderer(pRenderTarget, new RendererResources(meshLoadOptions))
+{
+	m_pOwnedResources = const_cast<RendererResources*>(m_pResources);
+}
+
+Renderer::Renderer(RenderTarget* pRenderTarget, const RendererResources* pResources, int vertexWorkerCount) :
+	m_pRenderTarget(pRenderTarget),
+	m_pDrawTarget(pRenderTarget),
+	m_pResources(pResources),
+	m_Width(pRenderTarget->GetWidth()),
+	m_Height(pRenderTarget->GetHeight())
+{
+	// the geometry and textures are shared, only the transformed vertices and the mesh placement belong to this renderer
+	m_ObjectMeshes.reserve(pResources->GetMeshes().size());
+	for (const Mesh& mesh : pResources->GetMeshes())
+	{
+		m_ObjectMeshes.push_back(MeshRenderState{ &mesh });
+	}
+
+	//Create Buffers
+	m_pDepthBufferPixels = new float[m_Width * m_Height];
+	m_pThreadPool = vertexWorkerCount < 0 ? new ThreadPool() : new ThreadPool(unsigned(vertexWorkerCount));
 
 	//Initialize Camera
 	m_Camera.Initialize((m_Width / static_cast<float>(m_Height)), 45.f, { 0.f,5.f,-64.f });
@@ -42,72 +159,553 @@ Renderer::Renderer(SDL_Window* pWindow) :
 Renderer::~Renderer()
 {
 	delete[] m_pDepthBufferPixels;
-	delete m_pDiffuseTexture;
-	delete m_pNormalTexture;
-	delete m_pSpecularTexture;
-	delete m_pGlossinessTexture;
+	delete m_pScaledRenderTarget;
+	delete m_pThreadPool;
+	delete m_pOwnedResources;
 }
 
 void Renderer::Update(Timer* pTimer)
 {
 	m_Camera.Update(pTimer);
+	Update(pTimer->GetElapsed());
+}
+
+void Renderer::Update(float deltaTime)
+{
+	m_Camera.CalculateViewMatrix();
+	m_Camera.CalculateProjectionMatrix();
+	if (m_Camera.version != m_CameraVersion)
+	{
+		m_CameraVersion = m_Camera.version;
+		++m_ViewVersion;
+	}
 
 	if (m_doesRotate)
 	{
-		Matrix rotation{ Matrix::CreateRotationY(pTimer->GetElapsed()) };
-		for (Mesh& mesh : m_ObjectMeshes)
+		Matrix rotation{ Matrix::CreateRotationY(deltaTime) };
+		for (MeshRenderState& mesh : m_ObjectMeshes)
 		{
 			mesh.worldMatrix = rotation * mesh.worldMatrix;
+			++mesh.version;
 		}
 	}
 }
 
+void Renderer::SetMeshInstances(int meshIdx, const std::vector<MeshInstance>& instances)
+{
+	assert(m_ObjectMeshes[meshIdx].pMesh->primitiveTopology == PrimitiveTopology::TriangleList && "Instancing is only supported for triangle lists");
+	m_ObjectMeshes[meshIdx].instances = instances;
+	++m_ObjectMeshes[meshIdx].version;
+}
+
+void Renderer::SetMeshWorldMatrix(int meshIdx, const Matrix& worldMatrix)
+{
+	m_ObjectMeshes[meshIdx].worldMatrix = worldMatrix;
+	++m_ObjectMeshes[meshIdx].version;
+}
+
 int Renderer::CycleShadingMode()
 {
 	m_CurrentShadingMode = static_cast<ShadingMode>((int(m_CurrentShadingMode) + 1) % 4);
+	++m_ShadingVersion;
 	return int(m_CurrentShadingMode);
 }
 
 void Renderer::Render()
 {
-	//@START
-	//Lock BackBuffer
-	SDL_LockSurface(m_pBackBuffer);
+	PROFILE_ZONE("Frame");
 
+	//@START
 	Render_W4();
 
 	//@END
-	//Update SDL Surface
-	SDL_UnlockSurface(m_pBackBuffer);
-	SDL_BlitSurface(m_pBackBuffer, 0, m_pFrontBuffer, 0);
-	SDL_UpdateWindowSurface(m_pWindow);
+	m_PresentRect = m_DirtyRect;
+	if (m_pDrawTarget != m_pRenderTarget && !m_DirtyRect.IsEmpty())
+	{
+		PROFILE_ZONE("Upscale");
+
+		// every target pixel that filters a changed source pixel, a source pixel spans at least one target pixel
+		const float scaleX{ m_pRenderTarget->GetWidth() / float(m_Width) };
+		const float scaleY{ m_pRenderTarget->GetHeight() / float(m_Height) };
+		m_PresentRect = ScreenRect{ std::max(int((m_DirtyRect.minX - 1) * scaleX), 0), std::max(int((m_DirtyRect.minY - 1) * scaleY), 0),
+			std::min(int(std::ceil((m_DirtyRect.maxX + 1) * scaleX)), m_pRenderTarget->GetWidth()), std::min(int(std::ceil((m_DirtyRect.maxY + 1) * scaleY)), m_pRenderTarget->GetHeight()) };
+
+		const ScreenRect presentRect{ m_PresentRect };
+		m_pThreadPool->ParallelFor(size_t(presentRect.maxY - presentRect.minY), 32, [this, &presentRect](size_t begin, size_t end)
+			{
+				const ScreenRect rows{ presentRect.minX, presentRect.minY + int(begin), presentRect.maxX, presentRect.minY + int(end) };
+				RenderTarget::UpscaleBilinear(*m_pDrawTarget, *m_pRenderTarget, rows);
+			});
+	}
+
+	PROFILE_ZONE("Present");
+	m_pRenderTarget->Present(m_PresentRect);
 }
 
-void Renderer::VertexTransformationFunction(std::vector<Mesh>& meshes) const
+void Renderer::SetRenderScale(float scale)
 {
+	scale = Clamp(scale, 0.25f, 1.f);
+	const int width{ std::max(int(m_pRenderTarget->GetWidth() * scale + 0.5f), 1) };
+	const int height{ std::max(int(m_pRenderTarget->GetHeight() * scale + 0.5f), 1) };
+	m_RenderScale = scale;
+	if (width == m_Width && height == m_Height)
+	{
+		return;
+	}
+
+	if (width == m_pRenderTarget->GetWidth() && height == m_pRenderTarget->GetHeight())
+	{
+		m_pDrawTarget = m_pRenderTarget;
+	}
+	else
+	{
+		if (!m_pScaledRenderTarget)
+		{
+			m_pScaledRenderTarget = new MemoryRenderTarget(m_pRenderTarget->GetWidth(), m_pRenderTarget->GetHeight());
+		}
+		m_pScaledRenderTarget->SetSize(width, height);
+		m_pDrawTarget = m_pScaledRenderTarget;
+	}
+
+	// the depth buffer has room for the full resolution, only its row length changes
+	m_Width = width;
+	m_Height = height;
+	++m_ViewVersion;
+	Invalidate();
+}
+
+int Renderer::SelectShadingRate(const Vertex_Out& v0, const Vertex_Out& v1, const Vertex_Out& v2) const
+{
+	if (!m_useCoarseShading || m_showDepthBuffer)
+	{
+		return 1;
+	}
+
+	// detail of the corners and the center, a triangle is as busy as its busiest part
+	const Vector2 centerUV{ (v0.uv + v1.uv + v2.uv) / 3.f };
+	const float detail{ std::max({ m_pResources->GetShadingDetail(v0.uv), m_pResources->GetShadingDetail(v1.uv),
+		m_pResources->GetShadingDetail(v2.uv), m_pResources->GetShadingDetail(centerUV) }) };
+
+	if (detail < m_CoarseShadingDetail * 0.5f) return 4;
+	if (detail < m_CoarseShadingDetail) return 2;
+	return 1;
+}
+
+void Renderer::PrepareTemporalBuffers(bool copyHistory)
+{
+	PROFILE_ZONE("Temporal History");
+
+	// room for the full resolution, like the depth buffer
+	const size_t pixelCount{ size_t(m_pRenderTarget->GetWidth()) * m_pRenderTarget->GetHeight() };
+	if (m_History.size() != pixelCount)
+	{
+		m_History.resize(pixelCount);
+		m_SurfaceNormals.resize(pixelCount);
+		m_ShadingAges.resize(pixelCount);
+		m_MotionVectors.resize(pixelCount);
+	}
+
+	// pixels that are not redrawn did not move
+	ScreenRect motionRect{ m_MotionRect };
+	motionRect.Merge(m_DirtyRect);
+	motionRect.maxX = std::min(motionRect.maxX, m_Width);
+	motionRect.maxY = std::min(motionRect.maxY, m_Height);
+	for (int py{ motionRect.minY }; py < motionRect.maxY; ++py)
+	{
+		std::fill(m_MotionVectors.begin() + py * m_Width + motionRect.minX, m_MotionVectors.begin() + py * m_Width + motionRect.maxX, Vector2{});
+	}
+	m_MotionRect = m_DirtyRect;
+
+	// reprojection only reads inside the dirty rectangle, a moved mesh's old pixels are part of it
+	for (int py{ m_DirtyRect.minY }; py < m_DirtyRect.maxY; ++py)
+	{
+		const uint32_t* pColors{ m_pDrawTarget->GetRow(py) };
+		for (int px{ m_DirtyRect.minX }; px < m_DirtyRect.maxX; ++px)
+		{
+			const size_t pixelIdx{ size_t(px + py * m_Width) };
+			if (copyHistory)
+			{
+				m_History[pixelIdx] = HistorySample{ m_SurfaceNormals[pixelIdx], m_pDepthBufferPixels[pixelIdx], pColors[px], m_ShadingAges[pixelIdx] };
+			}
+			m_SurfaceNormals[pixelIdx] = Vector3{};
+		}
+	}
+}
+
+bool Renderer::ReprojectFragment(const Fragment& fragment, const Vector4 (&previousPositions)[3], const Vector3& normal)
+{
+	const Vector4 previous{ previousPositions[0] * fragment.weights[0] + previousPositions[1] * fragment.weights[1] + previousPositions[2] * fragment.weights[2] };
+	if (previous.w <= 0.f)
+	{
+		return false;
+	}
+
+	const Vector2 previousPixel{ (previous.x / previous.w + 1.f) * 0.5f * m_Width, (1.f - previous.y / previous.w) * 0.5f * m_Height };
+	const size_t pixelIdx{ size_t(fragment.px + fragment.py * m_Width) };
+	m_MotionVectors[pixelIdx] = Vector2{ float(fragment.px), float(fragment.py) } - previousPixel;
+
+	// bilinear between the four pixels around the previous position, every one of them has to show the same surface
+	const int historyX{ int(std::floor(previousPixel.x)) };
+	const int historyY{ int(std::floor(previousPixel.y)) };
+	if (historyX < m_DirtyRect.minX || historyX + 1 >= m_DirtyRect.maxX || historyY < m_DirtyRect.minY || historyY + 1 >= m_DirtyRect.maxY)
+	{
+		return false;
+	}
+
+	const float previousDepth{ previous.z / previous.w };
+	const float fractionX{ previousPixel.x - historyX };
+	const float fractionY{ previousPixel.y - historyY };
+	const float tapWeights[4]{ (1.f - fractionX) * (1.f - fractionY), fractionX * (1.f - fractionY), (1.f - fractionX) * fractionY, fractionX * fractionY };
+	float color[3]{};
+	uint8_t age{};
+	for (int tap{}; tap < 4; ++tap)
+	{
+		// disoccluded pixels show another surface or the background there, both fail one of the tests
+		const HistorySample& sample{ m_History[historyX + (tap & 1) + (historyY + (tap >> 1)) * m_Width] };
+		if (sample.age + 1 >= m_TemporalMaxAge
+			|| std::abs(previousDepth - sample.depth) > m_TemporalDepthTolerance
+			|| Vector3::Dot(normal, sample.normal) < m_TemporalNormalAgreement)
+		{
+			return false;
+		}
+
+		uint8_t r{}, g{}, b{};
+		RenderTarget::GetRGB(sample.color, r, g, b);
+		color[0] += r * tapWeights[tap];
+		color[1] += g * tapWeights[tap];
+		color[2] += b * tapWeights[tap];
+		age = std::max(age, sample.age);
+	}
+
+	m_pDrawTarget->GetRow(fragment.py)[fragment.px] = RenderTarget::MapRGB(uint8_t(color[0] + 0.5f), uint8_t(color[1] + 0.5f), uint8_t(color[2] + 0.5f));
+	m_ShadingAges[pixelIdx] = age + 1;
+	++m_FrameStatistics.pixelsReprojected;
+	return true;
+}
+
+ScreenRect Renderer::FindDirtyRect(const std::vector<bool>& isMeshChanged)
+{
+	const ScreenRect fullScreen{ 0, 0, m_Width, m_Height };
+	const bool isFullRedraw{ !m_IsBackBufferValid
+		|| m_ViewVersion != m_ViewVersion_backBuffer
+		|| m_ShadingVersion != m_ShadingVersion_backBuffer
+		|| m_MeshScreenRects.size() != m_ObjectMeshes.size() };
+
+	m_IsBackBufferValid = true;
+	m_ViewVersion_backBuffer = m_ViewVersion;
+	m_ShadingVersion_backBuffer = m_ShadingVersion;
+	m_MeshScreenRects.resize(m_ObjectMeshes.size());
+
+	// a moved mesh dirties the area it covered last frame and the area it covers now
+	ScreenRect dirtyRect{};
+	for (size_t idx{}; idx < m_ObjectMeshes.size(); ++idx)
+	{
+		if (!isFullRedraw && !isMeshChanged[idx])
+		{
+			continue;
+		}
+
+		dirtyRect.Merge(m_MeshScreenRects[idx]);
+		m_MeshScreenRects[idx] = CalculateScreenRect(m_ObjectMeshes[idx]);
+		dirtyRect.Merge(m_MeshScreenRects[idx]);
+	}
+
+	return isFullRedraw ? fullScreen : dirtyRect;
+}
+
+ScreenRect Renderer::CalculateScreenRect(const MeshRenderState& mesh) const
+{
+	// only triangles with all vertices on screen get rasterized, so off screen vertices can be skipped
+	ScreenRect rect{ m_Width, m_Height, 0, 0 };
+	for (uint32_t index : mesh.indices_out)
+	{
+		const Vector4& position{ mesh.vertices_out[index].position };
+		if (position.x < 0 || position.x > m_Width || position.y < 0 || position.y > m_Height)
+		{
+			continue;
+		}
+
+		rect.minX = std::min(rect.minX, int(position.x));
+		rect.minY = std::min(rect.minY, int(position.y));
+		rect.maxX = std::max(rect.maxX, int(position.x));
+		rect.maxY = std::max(rect.maxY, int(position.y));
+	}
+
+	if (rect.IsEmpty())
+	{
+		return {};
+	}
+
+	// same margin as the triangle bounding boxes in Render_W4
+	const int margin{ 1 };
+	return ScreenRect{ std::max(rect.minX - margin, 0), std::max(rect.minY - margin, 0),
+		std::min(rect.maxX + margin + 1, m_Width), std::min(rect.maxY + margin + 1, m_Height) };
+}
+
+void Renderer::VertexTransformationFunction(std::vector<MeshRenderState>& meshes)
+{
+	PROFILE_ZONE("Vertex Transform");
+	const Frustum frustum{ Frustum::FromMatrix(m_Camera.viewMatrix * m_Camera.projectionMatrix) };
+	m_FrameStatistics = {};
+
 	for (int idx{}; idx < meshes.size(); ++idx)
 	{
-		Matrix worldViewProjection = meshes[idx].worldMatrix * m_Camera.viewMatrix * m_Camera.projectionMatrix;
-		meshes[idx].vertices_out.clear();
+		MeshRenderState& mesh{ meshes[idx] };
+		const Mesh& geometry{ *mesh.pMesh };
+		++m_FrameStatistics.meshes;
+
+		// neither the mesh nor the view changed since vertices_out and indices_out were built
+		if (mesh.meshVersion_out == mesh.version && mesh.viewVersion_out == m_ViewVersion)
+		{
+			++m_FrameStatistics.meshesReused;
+			continue;
+		}
+		mesh.meshVersion_out = mesh.version;
+		mesh.viewVersion_out = m_ViewVersion;
+
+		if (!mesh.instances.empty())
+		{
+			TransformInstances(mesh, frustum);
+			continue;
+		}
+
+		// cheapest rejection first, nothing of a culled mesh reaches the vertex stage
+		if (IsOutsideFrustum(geometry, mesh.worldMatrix, frustum))
+		{
+			++m_FrameStatistics.meshesCulled;
+			mesh.indices_out.clear();
+			continue;
+		}
+
+		Matrix worldViewProjection = mesh.worldMatrix * m_Camera.viewMatrix * m_Camera.projectionMatrix;
+		const int lod{ SelectLOD(geometry, mesh.worldMatrix) };
+
+		// meshlets are built over the full resolution index buffer
+		if (lod == 0 && m_useMeshletCulling && !geometry.meshlets.empty())
+		{
+			TransformVisibleMeshlets(mesh, worldViewProjection, frustum);
+			continue;
+		}
+
+		mesh.vertices_out.resize(geometry.vertices.size());
+
+		m_pThreadPool->ParallelFor(geometry.vertices.size(), m_VertexBatchSize, [&](size_t begin, size_t end)
+			{
+				PROFILE_ZONE("Vertex Batch");
+				TransformVertices(std::span{ geometry.vertices }.subspan(begin, end - begin),
+					std::span{ mesh.vertices_out }.subspan(begin, end - begin), mesh.worldMatrix, worldViewProjection);
+			});
+		m_FrameStatistics.verticesTransformed += geometry.vertices.size();
+
+		mesh.indices_out = (lod == 0) ? geometry.indices : geometry.lods[lod - 1].indices;
+	}
+}
+
+bool Renderer::IsOutsideFrustum(const Mesh& mesh, const Matrix& worldMatrix, const Frustum& frustum)
+{
+	const BoundingSphere sphere{ mesh.boundingSphere.Transformed(worldMatrix) };
+	if (frustum.IsSphereOutside(sphere)) return true;
+
+	// the box is only tested when the sphere straddles a plane
+	return !frustum.IsSphereInside(sphere) && frustum.IsBoxOutside(mesh.boundingBox.Transformed(worldMatrix));
+}
+
+void Renderer::TransformInstances(MeshRenderState& mesh, const Frustum& frustum)
+{
+	const Mesh& geometry{ *mesh.pMesh };
+	const size_t vertexCount{ geometry.vertices.size() };
+
+	std::vector<Matrix> worldMatrices{};
+	std::vector<Matrix> worldViewProjections{};
+	std::vector<ColorRGB> tints{};
+	for (const MeshInstance& instance : mesh.instances)
+	{
+		++m_FrameStatistics.instances;
+
+		const Matrix worldMatrix{ mesh.worldMatrix * instance.worldMatrix };
+		if (IsOutsideFrustum(geometry, worldMatrix, frustum))
+		{
+			++m_FrameStatistics.instancesCulled;
+			continue;
+		}
+
+		worldMatrices.push_back(worldMatrix);
+		worldViewProjections.push_back(worldMatrix * m_Camera.viewMatrix * m_Camera.projectionMatrix);
+		tints.push_back(instance.tint);
+	}
+	const size_t instanceCount{ worldMatrices.size() };
+
+	// every visible instance gets its own range of vertices_out
+	mesh.vertices_out.resize(vertexCount * instanceCount);
+
+	// a batch of input vertices stays in cache while it is written out for every instance
+	m_pThreadPool->ParallelFor(vertexCount, m_VertexBatchSize, [&](size_t begin, size_t end)
+		{
+			PROFILE_ZONE("Vertex Batch");
+			for (size_t instanceIdx{}; instanceIdx < instanceCount; ++instanceIdx)
+			{
+				const std::span<Vertex_Out> verticesOut{ std::span{ mesh.vertices_out }.subspan(instanceIdx * vertexCount + begin, end - begin) };
+				TransformVertices(std::span{ geometry.vertices }.subspan(begin, end - begin), verticesOut, worldMatrices[instanceIdx], worldViewProjections[instanceIdx]);
+
+				for (Vertex_Out& vertex : verticesOut)
+				{
+					vertex.color *= tints[instanceIdx];
+				}
+			}
+		});
+	m_FrameStatistics.verticesTransformed += vertexCount * instanceCount;
+
+	mesh.indices_out.clear();
+	for (size_t instanceIdx{}; instanceIdx < instanceCount; ++instanceIdx)
+	{
+		const int lod{ SelectLOD(geometry, worldMatrices[instanceIdx]) };
+		const std::vector<uint32_t>& indices{ (lod == 0) ? geometry.indices : geometry.lods[lod - 1].indices };
+		const uint32_t offset{ uint32_t(instanceIdx * vertexCount) };
+
+		for (uint32_t index : indices)
+		{
+			mesh.indices_out.push_back(index + offset);
+		}
+	}
+}
+
+int Renderer::SelectLOD(const Mesh& mesh, const Matrix& worldMatrix) const
+{
+	if (!m_useLODs || mesh.lods.empty())
+	{
+		return 0;
+	}
+
+	// pixels covered by one object space unit at the mesh's distance
+	const float scale{ worldMatrix.GetMaxScale() };
+	const float distance{ std::max((worldMatrix.GetTranslation() - m_Camera.origin).Magnitude(), 0.1f) };
+	const float pixelsPerUnit{ scale * m_Camera.projectionMatrix[1][1] * m_Height * 0.5f / distance };
+
+	int lod{};
+	for (int idx{}; idx < mesh.lods.size(); ++idx)
+	{
+		if (mesh.lods[idx].error * pixelsPerUnit > m_LODPixelError)
+		{
+			break;
+		}
+		lod = idx + 1;
+	}
+
+	return lod;
+}
+
+Vertex_Out Renderer::TransformVertex(const Vertex& vertex, const Matrix& worldMatrix, const Matrix& worldViewProjection) const
+{
+	Vector4 transformedPosition{ vertex.position, 1.f };
+	transformedPosition = worldViewProjection.TransformPoint(transformedPosition);
+	const Vector3 transformedNormal{ worldMatrix.TransformVector(vertex.normal).Normalized() };
+	const Vector3 transformedTangent{ worldMatrix.TransformVector(vertex.tangent)/*.Normalized()*/ };
+	const Vector3 viewDirection{ (worldMatrix.TransformVector(vertex.position) - m_Camera.origin).Normalized() };
+
+	// perspective divide
+	transformedPosition.x /= transformedPosition.w;
+	transformedPosition.y /= transformedPosition.w;
+	transformedPosition.z /= transformedPosition.w;
+
+	ToScreenSpace(transformedPosition);
+
+	return Vertex_Out{ transformedPosition, vertex.color, vertex.uv, transformedNormal, transformedTangent, viewDirection };
+}
+
+void Renderer::TransformVertices(std::span<const Vertex> vertices, std::span<Vertex_Out> verticesOut, const Matrix& worldMatrix, const Matrix& worldViewProjection) const
+{
+	// attributes are gathered into small arrays so every attribute goes through one batched transform
+	constexpr size_t chunkSize{ 64 };
+	Vector3 positions[chunkSize]{};
+	Vector3 normals[chunkSize]{};
+	Vector3 tangents[chunkSize]{};
+	Vector4 projectedPositions[chunkSize]{};
+
+	for (size_t chunkBegin{}; chunkBegin < vertices.size(); chunkBegin += chunkSize)
+	{
+		const size_t count{ std::min(chunkSize, vertices.size() - chunkBegin) };
+		const Vertex* pVertices{ &vertices[chunkBegin] };
+
+		for (size_t idx{}; idx < count; ++idx)
+		{
+			positions[idx] = pVertices[idx].position;
+			normals[idx] = pVertices[idx].normal;
+			tangents[idx] = pVertices[idx].tangent;
+		}
+
+		worldViewProjection.TransformPoints(std::span{ positions, count }, std::span{ projectedPositions, count }, true);
+		worldMatrix.TransformVectors(std::span{ normals, count }, std::span{ normals, count });
+		worldMatrix.TransformVectors(std::span{ tangents, count }, std::span{ tangents, count });
+		// same as TransformVertex, the view direction ignores the translation
+		worldMatrix.TransformVectors(std::span{ positions, count }, std::span{ positions, count });
+
+		for (size_t idx{}; idx < count; ++idx)
+		{
+			ToScreenSpace(projectedPositions[idx]);
+			verticesOut[chunkBegin + idx] = Vertex_Out{ projectedPositions[idx], pVertices[idx].color, pVertices[idx].uv,
+				normals[idx].Normalized(), tangents[idx], (positions[idx] - m_Camera.origin).Normalized() };
+		}
+	}
+}
+
+void Renderer::ToScreenSpace(Vector4& position) const
+{
+	// NDC to screen space
+	position.x = ((position.x + 1) / 2) * m_Width;
+	position.y = ((1 - position.y) / 2) * m_Height;
+}
+
+void Renderer::TransformVisibleMeshlets(MeshRenderState& mesh, const Matrix& worldViewProjection, const Frustum& frustum)
+{
+	const Mesh& geometry{ *mesh.pMesh };
+
+	// bounds are in object space, the largest axis scale keeps the sphere conservative
+	const float scale{ mesh.worldMatrix.GetMaxScale() };
+
+	// only vertices of visible meshlets get transformed, the others keep stale data that no index refers to
+	mesh.vertices_out.resize(geometry.vertices.size());
+	mesh.indices_out.clear();
+	std::vector<bool> isTransformed(geometry.vertices.size(), false);
+
+	for (const Meshlet& meshlet : geometry.meshlets)
+	{
+		const Vector3 center{ mesh.worldMatrix.TransformPoint(meshlet.center) };
+		const float radius{ meshlet.radius * scale };
+		++m_FrameStatistics.meshlets;
 
-		for (int verticeIdx{}; verticeIdx < meshes[idx].vertices.size(); ++verticeIdx)
-		{			
-			Vector4 transformedPosition{ meshes[idx].vertices[verticeIdx].position, 1.f };
-			transformedPosition = worldViewProjection.TransformPoint(transformedPosition);
-			const Vector3 transformedNormal{ meshes[idx].worldMatrix.TransformVector(meshes[idx].vertices[verticeIdx].normal).Normalized()};
-			const Vector3 transformedTangent{ meshes[idx].worldMatrix.TransformVector(meshes[idx].vertices[verticeIdx].tangent)/*.Normalized()*/};
-			const Vector3 viewDirection{ (meshes[idx].worldMatrix.TransformVector(meshes[idx].vertices[verticeIdx].position) - m_Camera.origin).Normalized()};
+		if (frustum.IsSphereOutside(center, radius))
+		{
+			++m_FrameStatistics.meshletsCulled;
+			continue;
+		}
 
-			// perspective divide
-			transformedPosition.x /= transformedPosition.w;
-			transformedPosition.y /= transformedPosition.w;
-			transformedPosition.z /= transformedPosition.w;
+		if (meshlet.coneCutoff < 1.f)
+		{
+			const Vector3 coneAxis{ mesh.worldMatrix.TransformVector(meshlet.coneAxis).Normalized() };
+			const Vector3 cameraToCenter{ center - m_Camera.origin };
+			if (Vector3::Dot(cameraToCenter, coneAxis) >= meshlet.coneCutoff * cameraToCenter.Magnitude() + radius)
+			{
+				++m_FrameStatistics.meshletsCulled;
+				continue;
+			}
+		}
 
-			// NDC to screen space
-			transformedPosition.x = ((transformedPosition.x + 1) / 2) * m_Width;
-			transformedPosition.y = ((1 - transformedPosition.y) / 2) * m_Height;
+		const uint32_t* pVertices{ &geometry.meshletVertices[meshlet.vertexOffset] };
+		for (uint32_t idx{}; idx < meshlet.vertexCount; ++idx)
+		{
+			const uint32_t vertexIdx{ pVertices[idx] };
+			if (!isTransformed[vertexIdx])
+			{
+				mesh.vertices_out[vertexIdx] = TransformVertex(geometry.vertices[vertexIdx], mesh.worldMatrix, worldViewProjection);
+				isTransformed[vertexIdx] = true;
+				++m_FrameStatistics.verticesTransformed;
+			}
+		}
 
-			meshes[idx].vertices_out.push_back(Vertex_Out{ transformedPosition, meshes[idx].vertices[verticeIdx].color, meshes[idx].vertices[verticeIdx].uv, transformedNormal, transformedTangent, viewDirection });
+		const uint8_t* pTriangles{ &geometry.meshletTriangles[meshlet.triangleOffset * 3] };
+		for (uint32_t idx{}; idx < meshlet.triangleCount * 3; ++idx)
+		{
+			mesh.indices_out.push_back(pVertices[pTriangles[idx]]);
 		}
 	}
 }
@@ -142,13 +740,13 @@ bool Renderer::IsPixelInTriangle(const std::vector<Vertex_Out>& vertices, const
 	return true;
 }
 
-const std::vector<Vertex_Out> Renderer::CreateOrderedVertices(const Mesh& mesh)
+const std::vector<Vertex_Out> Renderer::CreateOrderedVertices(const MeshRenderState& mesh)
 {
 	std::vector<Vertex_Out> result;
 
-	for (int idx = 0; idx < mesh.indices.size(); idx++)
+	for (int idx = 0; idx < mesh.indices_out.size(); idx++)
 	{
-		result.push_back(mesh.vertices_out[mesh.indices[idx]]);
+		result.push_back(mesh.vertices_out[mesh.indices_out[idx]]);
 	}
 
 	return result;
@@ -205,6 +803,60 @@ bool Renderer::IsOutsideFrustum(const Vertex_Out& v0, const Vertex_Out& v1, cons
 }
 
 ColorRGB Renderer::PixelShading(const Vertex_Out& v)
+{
+	return AddViewDependentShading(ShadeTexel(v), v);
+}
+
+ColorRGB Renderer::PixelShadingCached(const Vertex_Out& v, size_t meshIdx, int cacheLevel)
+{
+	const Texture* pNormalTexture{ m_pResources->GetNormalTexture() };
+	TextureShadingCache& cache{ GetTextureShadingCache(meshIdx) };
+
+	const int width{ std::max(pNormalTexture->GetWidth() >> cacheLevel, 1) };
+	const int height{ std::max(pNormalTexture->GetHeight() >> cacheLevel, 1) };
+	const int texelX{ Clamp(int(v.uv.x * width), 0, width - 1) };
+	const int texelY{ Clamp(int(v.uv.y * height), 0, height - 1) };
+	TexelShading& texel{ cache.texels[m_TextureCacheOffsets[cacheLevel] + texelX + size_t(texelY) * width] };
+
+	// the interpolated normal and tangent aren't normalized
+	const auto isAligned{ [this](const Vector3& a, const Vector3& b)
+		{
+			const float dot{ Vector3::Dot(a, b) };
+			return dot > 0.f && dot * dot >= m_TextureCacheFrameAgreement * m_TextureCacheFrameAgreement * a.SqrMagnitude() * b.SqrMagnitude();
+		} };
+
+	// the key is only the uv, a pixel of another triangle mapped onto the same texels gets its own shading
+	if (texel.stamp != cache.stamp || !isAligned(texel.normal, v.normal) || !isAligned(texel.tangent, v.tangent))
+	{
+		// shaded at the entry's center, with this pixel's normal and tangent
+		Vertex_Out texelVertex{ v };
+		texelVertex.uv = Vector2{ (texelX + 0.5f) / width, (texelY + 0.5f) / height };
+		texel = ShadeTexel(texelVertex);
+		texel.normal = v.normal;
+		texel.tangent = v.tangent;
+		texel.stamp = cache.stamp;
+		++m_FrameStatistics.texelsShaded;
+	}
+
+	return AddViewDependentShading(texel, v);
+}
+
+int Renderer::SelectTextureCacheLevel(const Vertex_Out& v0, const Vertex_Out& v1, const Vertex_Out& v2) const
+{
+	// normal map texels per pixel, every level divides it by 4
+	const float screenArea{ std::abs(Vector2::Cross(Vector2{ v1.position.x - v0.position.x, v1.position.y - v0.position.y },
+		Vector2{ v2.position.x - v0.position.x, v2.position.y - v0.position.y })) };
+	const float texelArea{ std::abs(Vector2::Cross(v1.uv - v0.uv, v2.uv - v0.uv))
+		* m_pResources->GetNormalTexture()->GetWidth() * m_pResources->GetNormalTexture()->GetHeight() };
+	if (screenArea <= 0.f || texelArea <= 0.f)
+	{
+		return 0;
+	}
+
+	return Clamp(int(std::floor(0.5f * std::log2(texelArea / screenArea))), 0, TEXTURE_CACHE_LEVELS - 1);
+}
+
+Renderer::TexelShading Renderer::ShadeTexel(const Vertex_Out& v) const
 {
 	float observedArea{};
 	if (m_useNormals)
@@ -213,7 +865,7 @@ ColorRGB Renderer::PixelShading(const Vertex_Out& v)
 		const Vector3 binormal{ Vector3::Cross(v.normal, v.tangent) };
 		Matrix tangentScapeAxis{ v.tangent, binormal, v.normal, {} };
 
-		const ColorRGB normalMapSample{ m_pNormalTexture->Sample(v.uv) };
+		const ColorRGB normalMapSample{ m_pResources->GetNormalTexture()->Sample(v.uv) };
 		Vector3 normal{ 2.f * normalMapSample.r - 1.f, 2.f * normalMapSample.g - 1.f, 2.f * normalMapSample.b - 1.f };
 		normal = tangentScapeAxis.TransformVector(normal);
 
@@ -229,15 +881,60 @@ ColorRGB Renderer::PixelShading(const Vertex_Out& v)
 	switch (m_CurrentShadingMode)
 	{
 	case dae::Renderer::ShadingMode::ObservedAreaOnly:
-		return {observedArea, observedArea, observedArea};
+		return { { observedArea, observedArea, observedArea } };
 	case dae::Renderer::ShadingMode::Diffuse:
-		return Lambert(7.f, m_pDiffuseTexture->Sample(v.uv)) * observedArea;
+		return { Lambert(7.f, m_pResources->GetDiffuseTexture()->Sample(v.uv)) * observedArea };
 	case dae::Renderer::ShadingMode::Specular:
-		return Phong(m_pSpecularTexture->Sample(v.uv).r, m_pGlossinessTexture->Sample(v.uv).r * m_Shininess, m_LightDirection, -v.viewDirection, v.normal) * observedArea;
+		return { {}, m_pResources->GetSpecularTexture()->Sample(v.uv).r * observedArea, m_pResources->GetGlossinessTexture()->Sample(v.uv).r * m_Shininess };
 	case dae::Renderer::ShadingMode::Combined:
-		return (Lambert(7.f, m_pDiffuseTexture->Sample(v.uv)) + Phong(m_pSpecularTexture->Sample(v.uv).r, m_pGlossinessTexture->Sample(v.uv).r * m_Shininess, m_LightDirection, -v.viewDirection, v.normal) + m_Ambient) * observedArea;
+		return { (Lambert(7.f, m_pResources->GetDiffuseTexture()->Sample(v.uv)) + m_Ambient) * observedArea,
+			m_pResources->GetSpecularTexture()->Sample(v.uv).r * observedArea, m_pResources->GetGlossinessTexture()->Sample(v.uv).r * m_Shininess };
 	}
 
+	return {};
+}
+
+ColorRGB Renderer::AddViewDependentShading(const TexelShading& texel, const Vertex_Out& v) const
+{
+	// Phong is linear in its reflection, so the observed area can be folded into the cached part
+	if (texel.specularScale <= 0.f)
+	{
+		return texel.base;
+	}
+	return texel.base + Phong(texel.specularScale, texel.exponent, m_LightDirection, -v.viewDirection, v.normal);
+}
+
+Renderer::TextureShadingCache& Renderer::GetTextureShadingCache(size_t meshIdx)
+{
+	if (m_TextureShadingCaches.size() <= meshIdx)
+	{
+		m_TextureShadingCaches.resize(m_ObjectMeshes.size());
+	}
+
+	TextureShadingCache& cache{ m_TextureShadingCaches[meshIdx] };
+	if (cache.texels.empty())
+	{
+		const Texture* pNormalTexture{ m_pResources->GetNormalTexture() };
+		size_t size{};
+		for (int level{}; level < TEXTURE_CACHE_LEVELS; ++level)
+		{
+			m_TextureCacheOffsets[level] = size;
+			size += size_t(std::max(pNormalTexture->GetWidth() >> level, 1)) * std::max(pNormalTexture->GetHeight() >> level, 1);
+		}
+		cache.texels.resize(size);
+	}
+	return cache;
+}
+
+void Renderer::UpdateTextureShadingCache(size_t meshIdx)
+{
+	TextureShadingCache& cache{ GetTextureShadingCache(meshIdx) };
+	if (cache.meshVersion != m_ObjectMeshes[meshIdx].version || cache.shadingVersion != m_ShadingVersion)
+	{
+		++cache.stamp;
+		cache.meshVersion = m_ObjectMeshes[meshIdx].version;
+		cache.shadingVersion = m_ShadingVersion;
+	}
 }
 
 ColorRGB Renderer::Lambert(const float refectance, const ColorRGB color)
@@ -256,18 +953,49 @@ ColorRGB Renderer::Phong(const float reflection, const float exponent, const Vec
 
 bool Renderer::SaveBufferToImage() const
 {
-	return SDL_SaveBMP(m_pBackBuffer, "Rasterizer_ColorBuffer.bmp");
+	return m_pRenderTarget->SaveToBMP("Rasterizer_ColorBuffer.bmp");
 }
 
 void Renderer::Render_W4()
 {
+	std::vector<bool> isMeshChanged(m_ObjectMeshes.size());
+	for (size_t idx{}; idx < m_ObjectMeshes.size(); ++idx)
+	{
+		isMeshChanged[idx] = m_ObjectMeshes[idx].meshVersion_out != m_ObjectMeshes[idx].version;
+	}
+
 	VertexTransformationFunction(m_ObjectMeshes);
 
-	// fill depth buffer
-	std::fill_n(m_pDepthBufferPixels, m_Width * m_Height, FLT_MAX);
+	// everything outside the dirty rectangle is still valid from the previous frame
+	m_DirtyRect = FindDirtyRect(isMeshChanged);
+	m_FrameStatistics.pixelsRedrawn = m_DirtyRect.GetArea();
+	if (m_DirtyRect.IsEmpty())
+	{
+		return;
+	}
+
+	// the history is only trusted when the previous frame wrote it with the same settings
+	const bool isTemporal{ m_useTemporalReuse && !m_showDepthBuffer };
+	const bool isHistoryUsable{ isTemporal && m_IsHistoryValid && m_ShadingVersion_history == m_ShadingVersion };
+	m_IsHistoryValid = isTemporal;
+	m_ShadingVersion_history = m_ShadingVersion;
+	if (isTemporal)
+	{
+		PrepareTemporalBuffers(isHistoryUsable);
+	}
+
+	{
+		PROFILE_ZONE("Clear");
 
-	// clear backbuffer
-	SDL_FillRect(m_pBackBuffer, &m_pBackBuffer->clip_rect, SDL_MapRGB(m_pBackBuffer->format, 100, 100, 100));
+		// fill depth buffer
+		for (int py{ m_DirtyRect.minY }; py < m_DirtyRect.maxY; ++py)
+		{
+			std::fill(m_pDepthBufferPixels + py * m_Width + m_DirtyRect.minX, m_pDepthBufferPixels + py * m_Width + m_DirtyRect.maxX, FLT_MAX);
+		}
+
+		// clear backbuffer
+		m_pDrawTarget->Fill(m_DirtyRect, RenderTarget::MapRGB(100, 100, 100));
+	}
 
 	// Setting frequently used variables that are loop safe 
 	ColorRGB finalColor{};
@@ -277,68 +1005,195 @@ void Renderer::Render_W4()
 	std::pair<int, int> boundingBoxTopLeft{};
 	std::pair<int, int> boundingBoxBottomRight{};
 
-	for (const Mesh& mesh : m_ObjectMeshes)
+	m_PreviousWorldViewProjections.resize(m_ObjectMeshes.size());
+	for (size_t meshIdx{}; meshIdx < m_ObjectMeshes.size(); ++meshIdx)
 	{
-		const int increment{ (mesh.primitiveTopology == PrimitiveTopology::TriangleList) ? 3 : 1 };
-		const auto loopLenght{ (mesh.primitiveTopology == PrimitiveTopology::TriangleList) ? mesh.indices.size() : mesh.indices.size() - 2 };
+		const MeshRenderState& mesh{ m_ObjectMeshes[meshIdx] };
+		const Mesh& geometry{ *mesh.pMesh };
+		PROFILE_ZONE("Rasterize Mesh");
+		// per triangle stages are too short for zones, their time is summed over the mesh
+		PROFILE_COUNTER(setupCounts);
+		PROFILE_COUNTER(rasterizationCounts);
+		PROFILE_COUNTER(shadingCounts);
+
+		const int increment{ (geometry.primitiveTopology == PrimitiveTopology::TriangleList) ? 3 : 1 };
+		const auto loopLenght{ (geometry.primitiveTopology == PrimitiveTopology::TriangleList) ? mesh.indices_out.size() : mesh.indices_out.size() - 2 };
+
+		std::vector<Vertex_Out> vertices{};
+		{
+			PROFILE_ZONE("Primitive Assembly");
+			vertices = CreateOrderedVertices(mesh);
+		}
 
-		const std::vector<Vertex_Out> vertices{ CreateOrderedVertices(mesh) };
+		// takes this frame's normalized device coordinates to last frame's clip space, instances are always shaded
+		const Matrix worldViewProjection{ mesh.worldMatrix * m_Camera.viewMatrix * m_Camera.projectionMatrix };
+		const bool canReproject{ isHistoryUsable && mesh.instances.empty() };
+		const Matrix reprojection{ canReproject ? Matrix::Inverse(worldViewProjection) * m_PreviousWorldViewProjections[meshIdx] : Matrix{} };
+		m_PreviousWorldViewProjections[meshIdx] = worldViewProjection;
+
+		const bool useTextureCache{ m_useTextureSpaceShading && !m_showDepthBuffer && mesh.instances.empty() };
+		if (useTextureCache)
+		{
+			UpdateTextureShadingCache(meshIdx);
+		}
 
 		for (int triangleIdx{}; triangleIdx < loopLenght; triangleIdx += increment)
 		{
-			// check if triangle is inside frustum or cull
-			if (IsOutsideFrustum(vertices[triangleIdx], vertices[triangleIdx + 1], vertices[triangleIdx + 2]))
 			{
-				continue;
-			}
+				PROFILE_ACCUMULATE(setupCounts);
 
-			// calc bounding box
-			const int boundingBoxMargin{ 1 };
-			boundingBoxTopLeft.first      = Clamp(int(std::min({ vertices[triangleIdx].position.x, vertices[triangleIdx + 1].position.x, vertices[triangleIdx + 2].position.x })) - boundingBoxMargin, 0, m_Width - 1);
-			boundingBoxTopLeft.second     = Clamp(int(std::min({ vertices[triangleIdx].position.y, vertices[triangleIdx + 1].position.y, vertices[triangleIdx + 2].position.y })) - boundingBoxMargin, 0, m_Height - 1);
-			boundingBoxBottomRight.first  = Clamp(int(std::max({ vertices[triangleIdx].position.x, vertices[triangleIdx + 1].position.x, vertices[triangleIdx + 2].position.x })) + boundingBoxMargin, 0, m_Width - 1);
-			boundingBoxBottomRight.second = Clamp(int(std::max({ vertices[triangleIdx].position.y, vertices[triangleIdx + 1].position.y, vertices[triangleIdx + 2].position.y })) + boundingBoxMargin, 0, m_Height - 1);
+				// check if triangle is inside frustum or cull
+				if (IsOutsideFrustum(vertices[triangleIdx], vertices[triangleIdx + 1], vertices[triangleIdx + 2]))
+				{
+					continue;
+				}
+
+				// calc bounding box
+				const int boundingBoxMargin{ 1 };
+				boundingBoxTopLeft.first      = Clamp(int(std::min({ vertices[triangleIdx].position.x, vertices[triangleIdx + 1].position.x, vertices[triangleIdx + 2].position.x })) - boundingBoxMargin, 0, m_Width - 1);
+				boundingBoxTopLeft.second     = Clamp(int(std::min({ vertices[triangleIdx].position.y, vertices[triangleIdx + 1].position.y, vertices[triangleIdx + 2].position.y })) - boundingBoxMargin, 0, m_Height - 1);
+				boundingBoxBottomRight.first  = Clamp(int(std::max({ vertices[triangleIdx].position.x, vertices[triangleIdx + 1].position.x, vertices[triangleIdx + 2].position.x })) + boundingBoxMargin, 0, m_Width - 1);
+				boundingBoxBottomRight.second = Clamp(int(std::max({ vertices[triangleIdx].position.y, vertices[triangleIdx + 1].position.y, vertices[triangleIdx + 2].position.y })) + boundingBoxMargin, 0, m_Height - 1);
+
+				// only pixels inside the dirty rectangle are redrawn
+				boundingBoxTopLeft.first = std::max(boundingBoxTopLeft.first, m_DirtyRect.minX);
+				boundingBoxTopLeft.second = std::max(boundingBoxTopLeft.second, m_DirtyRect.minY);
+				boundingBoxBottomRight.first = std::min(boundingBoxBottomRight.first, m_DirtyRect.maxX);
+				boundingBoxBottomRight.second = std::min(boundingBoxBottomRight.second, m_DirtyRect.maxY);
+				if (boundingBoxTopLeft.first >= boundingBoxBottomRight.first || boundingBoxTopLeft.second >= boundingBoxBottomRight.second)
+				{
+					continue;
+				}
+				++m_FrameStatistics.trianglesRasterized;
+			}
 
-			for (int px{ boundingBoxTopLeft.first }; px < boundingBoxBottomRight.first; ++px)
+			// coverage and depth test first, the fragments that pass are shaded afterwards
+			m_Fragments.clear();
 			{
-				for (int py{ boundingBoxTopLeft.second }; py < boundingBoxBottomRight.second; ++py)
+				PROFILE_ACCUMULATE(rasterizationCounts);
+
+				for (int px{ boundingBoxTopLeft.first }; px < boundingBoxBottomRight.first; ++px)
 				{
-					if (IsPixelInTriangle(vertices, Vector2{ float(px), float(py) }, weights, triangleIdx, mesh.primitiveTopology == PrimitiveTopology::TriangleStrip))
+					for (int py{ boundingBoxTopLeft.second }; py < boundingBoxBottomRight.second; ++py)
 					{
-						const float triangleArea{ weights[0] + weights[1] + weights[2] };
-
-						// normalize weights
-						weights[0] /= triangleArea;
-						weights[1] /= triangleArea;
-						weights[2] /= triangleArea;
+						if (IsPixelInTriangle(vertices, Vector2{ float(px), float(py) }, weights, triangleIdx, geometry.primitiveTopology == PrimitiveTopology::TriangleStrip))
+						{
+							const float triangleArea{ weights[0] + weights[1] + weights[2] };
 
-						// check if pixel's depth value is smaller then stored one in depth buffer and inside [0,1] range
-						const float interpolatedZDepth{ 1 / ((1 / vertices[triangleIdx + 0].position.z) * weights[0] +
-															 (1 / vertices[triangleIdx + 1].position.z) * weights[1] +
-															 (1 / vertices[triangleIdx + 2].position.z) * weights[2]) };
+							// normalize weights
+							weights[0] /= triangleArea;
+							weights[1] /= triangleArea;
+							weights[2] /= triangleArea;
 
-						if (interpolatedZDepth > 0.f && interpolatedZDepth < 1.f && interpolatedZDepth < m_pDepthBufferPixels[px + (py * m_Width)])
-						{
-							m_pDepthBufferPixels[px + (py * m_Width)] = interpolatedZDepth;
+							// check if pixel's depth value is smaller then stored one in depth buffer and inside [0,1] range
+							const float interpolatedZDepth{ 1 / ((1 / vertices[triangleIdx + 0].position.z) * weights[0] +
+																 (1 / vertices[triangleIdx + 1].position.z) * weights[1] +
+																 (1 / vertices[triangleIdx + 2].position.z) * weights[2]) };
 
-							if (m_showDepthBuffer)
+							if (interpolatedZDepth > 0.f && interpolatedZDepth < 1.f && interpolatedZDepth < m_pDepthBufferPixels[px + (py * m_Width)])
 							{
-								float color = Remap(interpolatedZDepth, 0.995f, 1.f);
-								finalColor = { color, color, color };
+								m_pDepthBufferPixels[px + (py * m_Width)] = interpolatedZDepth;
+								m_Fragments.push_back(Fragment{ px, py, { weights[0], weights[1], weights[2] }, interpolatedZDepth });
 							}
-							else finalColor = PixelShading(InterpolatedVertexAtrributes(vertices[triangleIdx + 0], vertices[triangleIdx + 1], vertices[triangleIdx + 2], weights));
+						}
+					}
+				}
+			}
 
-							//Update Color in Buffer
-							finalColor.MaxToOne();
+			PROFILE_ACCUMULATE(shadingCounts);
+			m_FrameStatistics.fragments += m_Fragments.size();
 
-							m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-								static_cast<uint8_t>(finalColor.r * 255),
-								static_cast<uint8_t>(finalColor.g * 255),
-								static_cast<uint8_t>(finalColor.b * 255));
+			// blocks are aligned to the screen, a block is shaded at the first of its fragments and the color reused
+			const int shadingRate{ SelectShadingRate(vertices[triangleIdx], vertices[triangleIdx + 1], vertices[triangleIdx + 2]) };
+			const int firstBlockX{ boundingBoxTopLeft.first / shadingRate };
+			const int firstBlockY{ boundingBoxTopLeft.second / shadingRate };
+			const int blockCountX{ (boundingBoxBottomRight.first - 1) / shadingRate - firstBlockX + 1 };
+			if (shadingRate > 1)
+			{
+				const size_t blockCount{ size_t(blockCountX) * ((boundingBoxBottomRight.second - 1) / shadingRate - firstBlockY + 1) };
+				if (m_BlockStamps.size() < blockCount)
+				{
+					m_BlockStamps.resize(blockCount);
+					m_BlockColors.resize(blockCount);
+				}
+				++m_BlockStamp;
+			}
+
+			const int textureCacheLevel{ useTextureCache ? SelectTextureCacheLevel(vertices[triangleIdx], vertices[triangleIdx + 1], vertices[triangleIdx + 2]) : 0 };
+
+			// the corners' clip positions last frame, screen space weights interpolate them exactly before the divide
+			Vector4 previousPositions[3]{};
+			if (canReproject)
+			{
+				for (int corner{}; corner < 3; ++corner)
+				{
+					const Vector4& position{ vertices[triangleIdx + corner].position };
+					previousPositions[corner] = reprojection.TransformPoint(Vector4{ position.x / m_Width * 2.f - 1.f, 1.f - position.y / m_Height * 2.f, position.z, 1.f });
+				}
+			}
+
+			for (const Fragment& fragment : m_Fragments)
+			{
+				if (m_showDepthBuffer)
+				{
+					float color = Remap(fragment.depth, 0.995f, 1.f);
+					finalColor = { color, color, color };
+				}
+				else
+				{
+					if (isTemporal)
+					{
+						// the interpolated vertex normal is enough to tell surfaces at the same depth apart
+						const Vector3 normal{ (vertices[triangleIdx + 0].normal * fragment.weights[0] +
+											   vertices[triangleIdx + 1].normal * fragment.weights[1] +
+											   vertices[triangleIdx + 2].normal * fragment.weights[2]).Normalized() };
+						m_SurfaceNormals[fragment.px + fragment.py * m_Width] = normal;
+
+						if (canReproject && ReprojectFragment(fragment, previousPositions, normal))
+						{
+							continue;
+						}
+
+						// fresh colors start at different ages so they don't all expire in the same frame
+						m_ShadingAges[fragment.px + fragment.py * m_Width] = uint8_t((fragment.px + fragment.py * 3) % (m_TemporalMaxAge / 2));
+					}
+
+					const size_t blockIdx{ size_t(fragment.px / shadingRate - firstBlockX) + size_t(fragment.py / shadingRate - firstBlockY) * blockCountX };
+					if (shadingRate > 1 && m_BlockStamps[blockIdx] == m_BlockStamp)
+					{
+						finalColor = m_BlockColors[blockIdx];
+					}
+					else
+					{
+						weights[0] = fragment.weights[0];
+						weights[1] = fragment.weights[1];
+						weights[2] = fragment.weights[2];
+
+						// vertex color carries the instance tint
+						const Vertex_Out pixelVertex{ InterpolatedVertexAtrributes(vertices[triangleIdx + 0], vertices[triangleIdx + 1], vertices[triangleIdx + 2], weights) };
+						finalColor = (useTextureCache ? PixelShadingCached(pixelVertex, meshIdx, textureCacheLevel) : PixelShading(pixelVertex)) * pixelVertex.color;
+						++m_FrameStatistics.shadingInvocations;
+
+						if (shadingRate > 1)
+						{
+							m_BlockColors[blockIdx] = finalColor;
+							m_BlockStamps[blockIdx] = m_BlockStamp;
 						}
 					}
 				}
+
+				//Update Color in Buffer
+				finalColor.MaxToOne();
+
+				m_pDrawTarget->GetRow(fragment.py)[fragment.px] = RenderTarget::MapRGB(
+					static_cast<uint8_t>(finalColor.r * 255),
+					static_cast<uint8_t>(finalColor.g * 255),
+					static_cast<uint8_t>(finalColor.b * 255));
 			}
 		}
+
+		PROFILE_SUBMIT("Triangle Setup", setupCounts);
+		PROFILE_SUBMIT("Rasterization", rasterizationCounts);
+		PROFILE_SUBMIT("Shading", shadingCounts);
 	}
 }
\ No newline at end of file
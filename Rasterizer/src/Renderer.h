@@ -1,26 +1,110 @@
 #pragma once
 
 #include <cstdint>
+#include <span>
 #include <vector>
 
 #include "Camera.h"
-
-struct SDL_Window;
-struct SDL_Surface;
+#include "RenderTarget.h"
 
 namespace dae
 {
 	class Texture;
 	struct Mesh;
+	struct MeshRenderState;
 	struct Vertex;
 	struct Vertex_Out;
 	class Timer;
 	class Scene;
+	class ThreadPool;
+	struct Frustum;
+	struct MeshInstance;
+
+	struct MeshLoadOptions
+	{
+		bool optimize{ false };
+		bool buildMeshlets{ false };
+		bool buildLODs{ false };
+	};
+
+	struct FrameStatistics
+	{
+		int meshes{};
+		int meshesCulled{};
+		// meshes whose vertices_out was still valid and skipped the vertex stage
+		int meshesReused{};
+		int instances{};
+		int instancesCulled{};
+		int meshlets{};
+		int meshletsCulled{};
+		size_t verticesTransformed{};
+		size_t trianglesRasterized{};
+		// pixels that passed the depth test, and how many PixelShading calls their colors took
+		size_t fragments{};
+		size_t shadingInvocations{};
+		// fragments that took their color from the previous frame instead of being shaded
+		size_t pixelsReprojected{};
+		// texels of the texture space shading cache that had to be (re)evaluated
+		size_t texelsShaded{};
+		// size of the redrawn rectangle, 0 when the previous frame was reused as is
+		size_t pixelsRedrawn{};
+	};
+
+	// textures and preprocessed meshes, loaded once and only read by the renderers made from them
+	class RendererResources final
+	{
+	public:
+		explicit RendererResources(const MeshLoadOptions& meshLoadOptions = {});
+		// meshes replace Resources/vehicle.obj, the vehicle textures are still loaded
+		explicit RendererResources(std::vector<Mesh> meshes, const MeshLoadOptions& meshLoadOptions = {});
+		~RendererResources();
+
+		RendererResources(const RendererResources&) = delete;
+		RendererResources(RendererResources&&) noexcept = delete;
+		RendererResources& operator=(const RendererResources&) = delete;
+		RendererResources& operator=(RendererResources&&) noexcept = delete;
+
+		const Texture* GetDiffuseTexture() const { return m_pDiffuseTexture; };
+		const Texture* GetNormalTexture() const { return m_pNormalTexture; };
+		const Texture* GetSpecularTexture() const { return m_pSpecularTexture; };
+		const Texture* GetGlossinessTexture() const { return m_pGlossinessTexture; };
+		const std::vector<Mesh>& GetMeshes() const { return m_Meshes; };
+
+		// how much the shading can change within the uv tile around uv, 0 for a flat, single colored area
+		float GetShadingDetail(const Vector2& uv) const;
+
+		static constexpr int DETAIL_GRID_SIZE{ 32 };
+
+	private:
+		static std::vector<Mesh> LoadVehicleMeshes();
+		void BuildShadingDetail();
+
+		Texture* m_pDiffuseTexture{ nullptr };
+		Texture* m_pNormalTexture{ nullptr };
+		Texture* m_pSpecularTexture{ nullptr };
+		Texture* m_pGlossinessTexture{ nullptr };
+
+		std::vector<Mesh> m_Meshes;
+		// DETAIL_GRID_SIZE x DETAIL_GRID_SIZE uv tiles
+		std::vector<float> m_ShadingDetail{};
+	};
 
 	class Renderer final
 	{
 	public:
-		Renderer(SDL_Window* pWindow);
+		enum class ShadingMode
+		{
+			ObservedAreaOnly,
+			Diffuse, // includes OA
+			Specular, // includes OA
+			Combined
+		};
+
+		// draws into pRenderTarget and presents through it, the target must outlive the renderer
+		Renderer(RenderTarget* pRenderTarget, const MeshLoadOptions& meshLoadOptions = {});
+		// uses pResources without copying the textures, several renderers can share it from different threads.
+		// vertexWorkerCount 0 keeps the vertex stage on the rendering thread, -1 uses one worker per hardware thread
+		Renderer(RenderTarget* pRenderTarget, const RendererResources* pResources, int vertexWorkerCount = -1);
 		~Renderer();
 
 		Renderer(const Renderer&) = delete;
@@ -29,6 +113,8 @@ namespace dae
 		Renderer& operator=(Renderer&&) noexcept = delete;
 
 		void Update(Timer* pTimer);
+		// camera input is skipped, the camera only moves when changed through GetCamera
+		void Update(float deltaTime);
 		void Render();
 
 		void Render_W4();
@@ -36,60 +122,210 @@ namespace dae
 		bool SaveBufferToImage() const;
 
 		int CycleShadingMode();
-		void ToggleShowDepthBuffer() { m_showDepthBuffer = !m_showDepthBuffer; };
+		void SetShadingMode(ShadingMode shadingMode) { m_CurrentShadingMode = shadingMode; ++m_ShadingVersion; };
+		void ToggleShowDepthBuffer() { m_showDepthBuffer = !m_showDepthBuffer; ++m_ShadingVersion; };
 		void ToggleRotation() { m_doesRotate = !m_doesRotate; };
-		void ToggleUseNormals() { m_useNormals = !m_useNormals; };
+		void ToggleUseNormals() { m_useNormals = !m_useNormals; ++m_ShadingVersion; };
+		void ToggleMeshletCulling() { m_useMeshletCulling = !m_useMeshletCulling; ++m_ViewVersion; };
+		void ToggleLODSelection() { m_useLODs = !m_useLODs; ++m_ViewVersion; };
+		void ToggleCoarseShading() { m_useCoarseShading = !m_useCoarseShading; ++m_ShadingVersion; };
+		void ToggleTemporalReuse() { m_useTemporalReuse = !m_useTemporalReuse; ++m_ShadingVersion; };
+		void ToggleTextureSpaceShading() { m_useTextureSpaceShading = !m_useTextureSpaceShading; ++m_ShadingVersion; };
+
+		void SetMeshInstances(int meshIdx, const std::vector<MeshInstance>& instances);
+		void SetMeshWorldMatrix(int meshIdx, const Matrix& worldMatrix);
 
-		void VertexTransformationFunction(std::vector<Mesh>& meshes) const;
+		// Renders at scale times the render target's size and upscales in the present step. Buffers are sized for the
+		// full resolution up front, changing the scale only costs a full redraw.
+		void SetRenderScale(float scale);
+		float GetRenderScale() const { return m_RenderScale; };
+
+		// forces the next frame to be fully redrawn, e.g. after the window contents were lost
+		void Invalidate() { m_IsBackBufferValid = false; m_IsHistoryValid = false; };
+
+		const FrameStatistics& GetFrameStatistics() const { return m_FrameStatistics; };
+		// what the last Render changed in the render target
+		const ScreenRect& GetDirtyRect() const { return m_PresentRect; };
+		// Screen space movement of every pixel since the previous frame in render resolution pixels, row length
+		// GetWidth(). Only written while temporal reuse is on, zero where nothing moved.
+		const std::vector<Vector2>& GetMotionVectors() const { return m_MotionVectors; };
+		Camera& GetCamera() { return m_Camera; };
+		const RenderTarget& GetRenderTarget() const { return *m_pRenderTarget; };
+		int GetWidth() const { return m_Width; };
+		int GetHeight() const { return m_Height; };
+
+		void VertexTransformationFunction(std::vector<MeshRenderState>& meshes);
+		Vertex_Out TransformVertex(const Vertex& vertex, const Matrix& worldMatrix, const Matrix& worldViewProjection) const;
+		void TransformVertices(std::span<const Vertex> vertices, std::span<Vertex_Out> verticesOut, const Matrix& worldMatrix, const Matrix& worldViewProjection) const;
+		void ToScreenSpace(Vector4& position) const;
+		void TransformVisibleMeshlets(MeshRenderState& mesh, const Matrix& worldViewProjection, const Frustum& frustum);
+		void TransformInstances(MeshRenderState& mesh, const Frustum& frustum);
+		int SelectLOD(const Mesh& mesh, const Matrix& worldMatrix) const;
+		// 1, 2 or 4: the triangle is shaded once per rate x rate pixel block
+		int SelectShadingRate(const Vertex_Out& v0, const Vertex_Out& v1, const Vertex_Out& v2) const;
 
 		bool IsPixelInTriangle(const std::vector<Vertex_Out>& vertices, const Vector2& pixel, std::vector<float>& weights, const int startIdx = 0, const bool strip = false);
 
-		const std::vector<Vertex_Out> CreateOrderedVertices(const Mesh& mesh);
+		const std::vector<Vertex_Out> CreateOrderedVertices(const MeshRenderState& mesh);
 
 		const Vertex_Out InterpolatedVertexAtrributes(const Vertex_Out& v0, const Vertex_Out& v1, const Vertex_Out& v2, const std::vector<float> weights);
 
+		ScreenRect FindDirtyRect(const std::vector<bool>& isMeshChanged);
+		ScreenRect CalculateScreenRect(const MeshRenderState& mesh) const;
+
 		bool IsOutsideFrustum(const Vertex_Out& v0, const Vertex_Out& v1, const Vertex_Out& v2);
+		static bool IsOutsideFrustum(const Mesh& mesh, const Matrix& worldMatrix, const Frustum& frustum);
 
 		ColorRGB PixelShading(const Vertex_Out& v);
+		// Same as PixelShading, but the view independent terms come from the mesh's cache laid over the normal map, level 0
+		// has one entry per texel and every level after it half the resolution. An entry is evaluated with the normal and
+		// tangent of the first pixel that samples it and reused by pixels whose normal and tangent agree with those, until
+		// the mesh or the shading settings change. Parts of a mesh that share uvs evict each other instead of sharing results.
+		ColorRGB PixelShadingCached(const Vertex_Out& v, size_t meshIdx, int cacheLevel = 0);
+		// the cache level whose entries are about as large as the triangle's pixels
+		int SelectTextureCacheLevel(const Vertex_Out& v0, const Vertex_Out& v1, const Vertex_Out& v2) const;
+
+		static constexpr int TEXTURE_CACHE_LEVELS{ 5 };
 		static inline ColorRGB Lambert(const float refectance, const ColorRGB color);
 		static ColorRGB Phong(const float reflection, const float exponent, const Vector3& l, const Vector3& v, const Vector3& n);
 
 	private:
-		SDL_Window* m_pWindow{};
-
-		SDL_Surface* m_pFrontBuffer{ nullptr };
-		SDL_Surface* m_pBackBuffer{ nullptr };
-		uint32_t* m_pBackBufferPixels{};
+		RenderTarget* m_pRenderTarget{};
+		// drawn into below full resolution, created the first time the scale drops
+		MemoryRenderTarget* m_pScaledRenderTarget{ nullptr };
+		// m_pRenderTarget or m_pScaledRenderTarget
+		RenderTarget* m_pDrawTarget{};
+		float m_RenderScale{ 1.f };
 
 		float* m_pDepthBufferPixels{};
 
-		Texture* m_pDiffuseTexture{ nullptr };
-		Texture* m_pNormalTexture{ nullptr };
-		Texture* m_pSpecularTexture{ nullptr };
-		Texture* m_pGlossinessTexture{ nullptr };
+		const RendererResources* m_pResources{ nullptr };
+		// only set when the renderer loaded its own resources
+		RendererResources* m_pOwnedResources{ nullptr };
 
 		Camera m_Camera{};
 
+		// bumped when the camera or a setting that changes vertex stage output changes
+		uint32_t m_ViewVersion{ 1 };
+		uint32_t m_CameraVersion{};
+		// bumped by every toggle that changes the shaded pixels
+		uint32_t m_ShadingVersion{ 1 };
+
+		// versions the back buffer was drawn with, only the dirty rectangle is redrawn while they match
+		bool m_IsBackBufferValid{ false };
+		uint32_t m_ViewVersion_backBuffer{};
+		uint32_t m_ShadingVersion_backBuffer{};
+		std::vector<ScreenRect> m_MeshScreenRects{};
+		// in render resolution pixels, m_PresentRect is the same area on m_pRenderTarget
+		ScreenRect m_DirtyRect{};
+		ScreenRect m_PresentRect{};
+
+		ThreadPool* m_pThreadPool{ nullptr };
+
+		// render resolution, the render target's size times m_RenderScale
 		int m_Width{};
 		int m_Height{};
 
-		enum class ShadingMode
-		{
-			ObservedAreaOnly,
-			Diffuse, // includes OA
-			Specular, // includes OA
-			Combined
-		};
-
 		ShadingMode m_CurrentShadingMode{ ShadingMode::Combined };
 		bool m_showDepthBuffer{ false };
 		bool m_doesRotate{ true };
 		bool m_useNormals{ true };
+		bool m_useMeshletCulling{ true };
+		bool m_useLODs{ true };
+		bool m_useCoarseShading{ false };
+		bool m_useTemporalReuse{ false };
+		bool m_useTextureSpaceShading{ false };
+
+		// coarsest LOD whose error projects to at most this many pixels is picked
+		float m_LODPixelError{ 1.f };
+		// triangles whose textures vary less than this over their uvs are shaded per 2x2 pixels, less than half of it per 4x4
+		float m_CoarseShadingDetail{ 0.3f };
+		// a reprojected color is reused when its depth and normal agree this well and it was shaded fewer frames ago
+		float m_TemporalDepthTolerance{ 0.0002f };
+		float m_TemporalNormalAgreement{ 0.95f };
+		const uint8_t m_TemporalMaxAge{ 8 };
+
+		// vertices per thread pool task in the vertex stage
+		const size_t m_VertexBatchSize{ 256 };
 
 		Vector3 m_LightDirection;
 		float m_Shininess;
 		ColorRGB m_Ambient;
 
-		std::vector<Mesh> m_ObjectMeshes;
+		std::vector<MeshRenderState> m_ObjectMeshes;
+
+		// a pixel of the current triangle that passed the depth test, shaded once the triangle is rasterized
+		struct Fragment
+		{
+			int px{};
+			int py{};
+			float weights[3]{};
+			float depth{};
+		};
+		std::vector<Fragment> m_Fragments{};
+
+		// takes the previous frame's color when the surface under the fragment was already there, writes its motion vector
+		bool ReprojectFragment(const Fragment& fragment, const Vector4 (&previousPositions)[3], const Vector3& normal);
+		void PrepareTemporalBuffers(bool copyHistory);
+
+		// color of every shading rate block of the current triangle, valid where the stamp matches the triangle's
+		std::vector<ColorRGB> m_BlockColors{};
+		std::vector<uint32_t> m_BlockStamps{};
+		uint32_t m_BlockStamp{};
+
+		// last frame's surface under every pixel, copied over the dirty rectangle before it is redrawn
+		struct HistorySample
+		{
+			Vector3 normal{};
+			float depth{};
+			uint32_t color{};
+			uint8_t age{};
+		};
+		std::vector<HistorySample> m_History{};
+		// current frame's interpolated vertex normal and frames since the color was shaded, zero for the background
+		std::vector<Vector3> m_SurfaceNormals{};
+		std::vector<uint8_t> m_ShadingAges{};
+		std::vector<Vector2> m_MotionVectors{};
+		// pixels whose motion vectors may be non zero
+		ScreenRect m_MotionRect{};
+		// per mesh, where the history was drawn from
+		std::vector<Matrix> m_PreviousWorldViewProjections{};
+		bool m_IsHistoryValid{ false };
+		uint32_t m_ShadingVersion_history{};
+
+		// the lighting terms of PixelShading that don't depend on the view direction, already multiplied by the observed area
+		struct TexelShading
+		{
+			ColorRGB base{};
+			float specularScale{};
+			float exponent{};
+			// the interpolated frame it was shaded with, and the TextureShadingCache::stamp it belongs to
+			Vector3 normal{};
+			Vector3 tangent{};
+			uint32_t stamp{};
+		};
+		TexelShading ShadeTexel(const Vertex_Out& v) const;
+		ColorRGB AddViewDependentShading(const TexelShading& texel, const Vertex_Out& v) const;
+
+		// one per mesh, so meshes sharing a texture don't evict each other
+		struct TextureShadingCache
+		{
+			// every level after the other
+			std::vector<TexelShading> texels{};
+			// entries with an older stamp are stale, it changes with the mesh and shading versions
+			uint32_t stamp{ 1 };
+			uint32_t meshVersion{};
+			uint32_t shadingVersion{};
+		};
+		// The lighting of a texel depends on the orientation of the mesh it is on. Instanced meshes don't use the cache.
+		TextureShadingCache& GetTextureShadingCache(size_t meshIdx);
+		void UpdateTextureShadingCache(size_t meshIdx);
+
+		std::vector<TextureShadingCache> m_TextureShadingCaches{};
+		size_t m_TextureCacheOffsets[TEXTURE_CACHE_LEVELS]{};
+		// cosine between the frame an entry was shaded with and the pixel's frame that still reuses it
+		float m_TextureCacheFrameAgreement{ 0.99f };
+
+		FrameStatistics m_FrameStatistics{};
 	};
 }
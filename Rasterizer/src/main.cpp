@@ -1,15 +1,31 @@
 //External includes
+// Visual Leak Detector only ships for MSVC, the headless benchmark is also built with gcc/clang on Linux
+#ifdef _MSC_VER
 #include "vld.h"
+#endif
 #include "SDL.h"
 #include "SDL_surface.h"
 #undef main
 
 //Standard includes
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <vector>
 
 //Project includes
+#include "BatchRenderer.h"
+#include "Benchmark.h"
+#include "FrameStream.h"
+#include "ImageWriter.h"
 #include "Timer.h"
+#include "DataTypes.h"
+#include "DynamicResolution.h"
 #include "Renderer.h"
+#include "SharedFrameRing.h"
+#include "Profiler.h"
 
 using namespace dae;
 
@@ -19,18 +35,185 @@ void ShutDown(SDL_Window* pWindow)
 	SDL_Quit();
 }
 
-int main(int argc, char* args[])
+//Fleet of vehicles sharing one mesh, laid out on a grid
+void CreateInstanceGrid(Renderer* pRenderer, int gridSize)
 {
-	//Unreferenced parameters
-	(void)argc;
-	(void)args;
+	const float spacing = 30.f;
+	std::vector<MeshInstance> instances;
+	for (int x = 0; x < gridSize; ++x)
+	{
+		for (int z = 0; z < gridSize; ++z)
+		{
+			const float offset = (gridSize - 1) * spacing * 0.5f;
+			const ColorRGB tint = ColorRGB::Lerp(colors::White, colors::Yellow, float((x + z) % 2));
+			instances.push_back(MeshInstance{ Matrix::CreateTranslation(x * spacing - offset, 0.f, z * spacing), tint });
+		}
+	}
+	pRenderer->SetMeshInstances(0, instances);
+}
 
-	//Create window + surfaces
-	SDL_Init(SDL_INIT_VIDEO);
+// renders without a window and prints or writes the timings as JSON
+int RunBenchmark(uint32_t width, uint32_t height, const MeshLoadOptions& meshLoadOptions, int instanceGridSize, const BenchmarkOptions& benchmarkOptions, const char* pOutputPath)
+{
+	const auto pRenderTarget = new MemoryRenderTarget(width, height);
+	const auto pRenderer = new Renderer(pRenderTarget, meshLoadOptions);
+	if (instanceGridSize > 0)
+		CreateInstanceGrid(pRenderer, instanceGridSize);
+
+	const BenchmarkResult result = Benchmark::Run(pRenderer, benchmarkOptions);
+	delete pRenderer;
+	delete pRenderTarget;
+
+	if (!pOutputPath)
+	{
+		result.WriteJson(std::cout);
+		return 0;
+	}
+
+	std::ofstream file{ pOutputPath };
+	result.WriteJson(file);
+	if (!file)
+	{
+		std::cerr << "Something went wrong. Benchmark results not saved!" << std::endl;
+		return 1;
+	}
+	std::cerr << "Benchmark results saved to " << pOutputPath << std::endl;
+	return 0;
+}
+
+// screenshot.png -> screenshot_3.png, so earlier screenshots aren't overwritten
+std::string GetNumberedPath(const std::string& path, int number)
+{
+	const size_t dotIdx = path.find_last_of('.');
+	if (dotIdx == std::string::npos)
+		return path + "_" + std::to_string(number);
+	return path.substr(0, dotIdx) + "_" + std::to_string(number) + path.substr(dotIdx);
+}
+
+// renders every frame to disk on as many renderers as there are jobs, all sharing one copy of the resources
+int RunBatch(uint32_t width, uint32_t height, const MeshLoadOptions& meshLoadOptions, const std::vector<BatchFrame>& frames, const BatchOptions& batchOptions)
+{
+	const auto pResources = new RendererResources(meshLoadOptions);
+	const BatchResult result = BatchRenderer::Run(pResources, width, height, frames, batchOptions);
+	delete pResources;
+
+	std::cout << result.framesRendered << " frames saved to " << batchOptions.outputDirectory << " in " << result.seconds << " s with "
+		<< result.jobCount << " jobs (" << result.framesRendered / std::max(result.seconds, 1e-6) << " frames per second)" << std::endl;
+	if (result.framesFailed > 0)
+	{
+		std::cerr << "Something went wrong. " << result.framesFailed << " frames not saved!" << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+int main(int argc, char* args[])
+{
+	//Command line options
+	MeshLoadOptions meshLoadOptions{};
+	int instanceGridSize = 0;
+	bool isBenchmark = false;
+	BenchmarkOptions benchmarkOptions{};
+	const char* pBenchmarkOutputPath = nullptr;
+	std::vector<BatchFrame> batchFrames;
+	BatchOptions batchOptions{};
+	// 0 renders straight into the window, 1 copies to it on the rendering thread, 2 or 3 copy on their own thread while the next frame renders
+	int frameBufferCount = 0;
+	// the extension picks the encoder: .png, .qoi, .ppm or .bmp
+	std::string screenshotPath = "Rasterizer_ColorBuffer.png";
+	// every frame goes to this file or named pipe, e.g. for ffmpeg -i \\.\pipe\rasterizer
+	const char* pStreamPath = nullptr;
+	FrameStreamFormat streamFormat = FrameStreamFormat::Y4M;
+	int streamFramesPerSecond = 60;
+	// publishes every frame to a shared memory ring that local viewers can read without slowing the renderer down
+	const char* pSharedFramesName = nullptr;
+	// 0 keeps the full resolution, otherwise the render scale follows the frame time
+	float targetFrameMilliseconds = 0.f;
+	float minRenderScale = 0.5f;
+	// shades flat, low detail triangles once per 2x2 or 4x4 pixels, also toggled with F11
+	bool useCoarseShading = false;
+	// reuses last frame's colors where the surface only moved a little, also toggled with F12
+	bool useTemporalReuse = false;
+	// caches the view independent lighting per texel of the vehicle, also toggled with F3
+	bool useTextureSpaceShading = false;
+	for (int idx = 1; idx < argc; ++idx)
+	{
+		if (strcmp(args[idx], "--optimize-meshes") == 0)
+			meshLoadOptions.optimize = true;
+		if (strcmp(args[idx], "--meshlets") == 0)
+			meshLoadOptions.buildMeshlets = true;
+		if (strcmp(args[idx], "--lods") == 0)
+			meshLoadOptions.buildLODs = true;
+		if (strcmp(args[idx], "--instances") == 0 && idx + 1 < argc)
+			instanceGridSize = atoi(args[++idx]);
+		if (strcmp(args[idx], "--benchmark") == 0)
+			isBenchmark = true;
+		if (strcmp(args[idx], "--warmup-frames") == 0 && idx + 1 < argc)
+			benchmarkOptions.warmupFrames = atoi(args[++idx]);
+		if (strcmp(args[idx], "--frames") == 0 && idx + 1 < argc)
+			benchmarkOptions.measuredFrames = atoi(args[++idx]);
+		if (strcmp(args[idx], "--benchmark-output") == 0 && idx + 1 < argc)
+			pBenchmarkOutputPath = args[++idx];
+		if (strcmp(args[idx], "--camera-path") == 0 && idx + 1 < argc)
+		{
+			if (!CameraPath::LoadFromFile(args[++idx], benchmarkOptions.cameraPath))
+			{
+				std::cerr << "Could not read camera path " << args[idx] << std::endl;
+				return 1;
+			}
+		}
+		if (strcmp(args[idx], "--batch") == 0 && idx + 1 < argc)
+		{
+			if (!BatchRenderer::LoadFramesFromFile(args[++idx], batchFrames))
+			{
+				std::cerr << "Could not read batch frames " << args[idx] << std::endl;
+				return 1;
+			}
+		}
+		if (strcmp(args[idx], "--turntable") == 0 && idx + 1 < argc)
+			batchFrames = BatchRenderer::CreateTurntable(atoi(args[++idx]));
+		if (strcmp(args[idx], "--batch-output") == 0 && idx + 1 < argc)
+			batchOptions.outputDirectory = args[++idx];
+		if (strcmp(args[idx], "--jobs") == 0 && idx + 1 < argc)
+			batchOptions.jobCount = atoi(args[++idx]);
+		if (strcmp(args[idx], "--buffers") == 0 && idx + 1 < argc)
+			frameBufferCount = atoi(args[++idx]);
+		if (strcmp(args[idx], "--screenshot-path") == 0 && idx + 1 < argc)
+			screenshotPath = args[++idx];
+		if (strcmp(args[idx], "--stream") == 0 && idx + 1 < argc)
+			pStreamPath = args[++idx];
+		if (strcmp(args[idx], "--stream-rgba") == 0)
+			streamFormat = FrameStreamFormat::RawRGBA;
+		if (strcmp(args[idx], "--stream-fps") == 0 && idx + 1 < argc)
+			streamFramesPerSecond = atoi(args[++idx]);
+		if (strcmp(args[idx], "--shared-frames") == 0 && idx + 1 < argc)
+			pSharedFramesName = args[++idx];
+		if (strcmp(args[idx], "--target-frame-ms") == 0 && idx + 1 < argc)
+			targetFrameMilliseconds = float(atof(args[++idx]));
+		if (strcmp(args[idx], "--min-scale") == 0 && idx + 1 < argc)
+			minRenderScale = float(atof(args[++idx]));
+		if (strcmp(args[idx], "--coarse-shading") == 0)
+			useCoarseShading = true;
+		if (strcmp(args[idx], "--temporal") == 0)
+			useTemporalReuse = true;
+		if (strcmp(args[idx], "--texture-space-shading") == 0)
+			useTextureSpaceShading = true;
+		if (strcmp(args[idx], "--batch-format") == 0 && idx + 1 < argc)
+			batchOptions.fileExtension = args[++idx];
+	}
 
 	const uint32_t width = 640;
 	const uint32_t height = 480;
 
+	// no window and no video subsystem, so it also runs on machines without a display
+	if (isBenchmark)
+		return RunBenchmark(width, height, meshLoadOptions, instanceGridSize, benchmarkOptions, pBenchmarkOutputPath);
+	if (!batchFrames.empty())
+		return RunBatch(width, height, meshLoadOptions, batchFrames, batchOptions);
+
+	//Create window + surfaces
+	SDL_Init(SDL_INIT_VIDEO);
+
 	SDL_Window* pWindow = SDL_CreateWindow(
 		"Rasterizer - Hocedez Ine",
 		SDL_WINDOWPOS_UNDEFINED,
@@ -42,17 +225,54 @@ int main(int argc, char* args[])
 
 	//Initialize "framework"
 	const auto pTimer = new Timer();
-	const auto pRenderer = new Renderer(pWindow);
+	RenderTarget* pRenderTarget = nullptr;
+	if (frameBufferCount == 0 && !WindowRenderTarget::IsSupported(pWindow))
+	{
+		std::cout << "Window surface is not 32 bit XRGB, falling back to a copy on present" << std::endl;
+		frameBufferCount = 1;
+	}
+	if (frameBufferCount == 0)
+		pRenderTarget = new WindowRenderTarget(pWindow);
+	else if (frameBufferCount > 1)
+		pRenderTarget = new SwapChainRenderTarget(width, height, pWindow, frameBufferCount);
+	else
+		pRenderTarget = new MemoryRenderTarget(width, height, pWindow);
+	const auto pRenderer = new Renderer(pRenderTarget, meshLoadOptions);
+	const auto pImageWriter = new AsyncImageWriter();
+	FrameStreamWriter* pFrameStream = nullptr;
+	if (pStreamPath)
+	{
+		pFrameStream = new FrameStreamWriter(pStreamPath, streamFormat, pRenderTarget->GetWidth(), pRenderTarget->GetHeight(), streamFramesPerSecond);
+		if (!pFrameStream->IsOpen())
+			std::cout << "Could not open frame stream " << pStreamPath << std::endl;
+	}
+	DynamicResolution* pDynamicResolution = nullptr;
+	if (targetFrameMilliseconds > 0.f)
+		pDynamicResolution = new DynamicResolution(targetFrameMilliseconds, minRenderScale);
+	SharedFrameRingWriter* pSharedFrames = nullptr;
+	if (pSharedFramesName)
+	{
+		pSharedFrames = new SharedFrameRingWriter(pSharedFramesName, pRenderTarget->GetWidth(), pRenderTarget->GetHeight());
+		if (!pSharedFrames->IsOpen())
+			std::cout << "Could not create shared memory " << pSharedFramesName << std::endl;
+	}
+
+	if (instanceGridSize > 0)
+		CreateInstanceGrid(pRenderer, instanceGridSize);
+	if (useCoarseShading)
+		pRenderer->ToggleCoarseShading();
+	if (useTemporalReuse)
+		pRenderer->ToggleTemporalReuse();
+	if (useTextureSpaceShading)
+		pRenderer->ToggleTextureSpaceShading();
 
 	//Start loop
 	pTimer->Start();
 
-	// Start Benchmark
-	// TODO pTimer->StartBenchmark();
-
 	float printTimer = 0.f;
 	bool isLooping = true;
 	bool takeScreenshot = false;
+	int screenshotCount = 0;
 	while (isLooping)
 	{
 		//--------- Get input events ---------
@@ -64,9 +284,15 @@ int main(int argc, char* args[])
 			case SDL_QUIT:
 				isLooping = false;
 				break;
+			case SDL_WINDOWEVENT:
+				if (e.window.event == SDL_WINDOWEVENT_EXPOSED)
+					pRenderer->Invalidate();
+				break;
 			case SDL_KEYUP:
 				if (e.key.keysym.scancode == SDL_SCANCODE_X)
 					takeScreenshot = true;
+				if (e.key.keysym.scancode == SDL_SCANCODE_F3)
+					pRenderer->ToggleTextureSpaceShading();
 				if (e.key.keysym.scancode == SDL_SCANCODE_F4)
 					pRenderer->ToggleShowDepthBuffer();
 				if (e.key.keysym.scancode == SDL_SCANCODE_F5)
@@ -75,6 +301,26 @@ int main(int argc, char* args[])
 					pRenderer->ToggleUseNormals();				
 				if (e.key.keysym.scancode == SDL_SCANCODE_F7)
 					pRenderer->CycleShadingMode();
+				if (e.key.keysym.scancode == SDL_SCANCODE_F8)
+					pRenderer->ToggleMeshletCulling();
+				if (e.key.keysym.scancode == SDL_SCANCODE_F9)
+					pRenderer->ToggleLODSelection();
+				if (e.key.keysym.scancode == SDL_SCANCODE_F10)
+				{
+					if (!Profiler::Get().IsCapturing())
+					{
+						Profiler::Get().StartCapture();
+						std::cout << "Trace capture started, press F10 again to save it" << std::endl;
+					}
+					else if (Profiler::Get().WriteChromeTrace("Rasterizer_Trace.json"))
+						std::cout << "Trace saved to Rasterizer_Trace.json" << std::endl;
+					else
+						std::cout << "Something went wrong. Trace not saved!" << std::endl;
+				}
+				if (e.key.keysym.scancode == SDL_SCANCODE_F11)
+					pRenderer->ToggleCoarseShading();
+				if (e.key.keysym.scancode == SDL_SCANCODE_F12)
+					pRenderer->ToggleTemporalReuse();
 				break;
 			}
 		}
@@ -83,7 +329,29 @@ int main(int argc, char* args[])
 		pRenderer->Update(pTimer);
 
 		//--------- Render ---------
+		const uint64_t renderStart = Profiler::Now();
 		pRenderer->Render();
+		Profiler::Get().EndFrame();
+
+		// frames that reused the previous image say nothing about the cost of rendering one
+		if (pDynamicResolution && pRenderer->GetFrameStatistics().pixelsRedrawn > 0)
+			pRenderer->SetRenderScale(pDynamicResolution->Update(float(Profiler::ToMilliseconds(Profiler::Now() - renderStart))));
+
+		// only frames with changes, readers keep showing the previous one
+		if (pSharedFrames && pRenderer->GetFrameStatistics().pixelsRedrawn > 0)
+			pSharedFrames->Publish(pRenderer->GetRenderTarget(), pRenderer->GetDirtyRect());
+
+		// waits when the reader is more than a few frames behind
+		if (pFrameStream && !pFrameStream->Submit(pRenderer->GetRenderTarget()))
+		{
+			std::cout << "Frame stream closed after " << pFrameStream->GetFramesWritten() << " frames" << std::endl;
+			delete pFrameStream;
+			pFrameStream = nullptr;
+		}
+
+		// nothing changed on screen, give the CPU back instead of spinning
+		if (pRenderer->GetFrameStatistics().pixelsRedrawn == 0)
+			SDL_Delay(10);
 
 		//--------- Timer ---------
 		pTimer->Update();
@@ -91,23 +359,46 @@ int main(int argc, char* args[])
 		if (printTimer >= 1.f)
 		{
 			printTimer = 0.f;
-			std::cout << "dFPS: " << pTimer->GetdFPS() << std::endl;
+			const FrameStatistics& stats = pRenderer->GetFrameStatistics();
+			std::cout << "dFPS: " << pTimer->GetdFPS()
+				<< " | meshes culled " << stats.meshesCulled << "/" << stats.meshes
+				<< ", reused " << stats.meshesReused
+				<< ", instances culled " << stats.instancesCulled << "/" << stats.instances
+				<< ", meshlets culled " << stats.meshletsCulled << "/" << stats.meshlets
+				<< ", vertices " << stats.verticesTransformed
+				<< ", triangles " << stats.trianglesRasterized
+				<< ", pixels redrawn " << stats.pixelsRedrawn
+				<< ", shaded " << stats.shadingInvocations << "/" << stats.fragments
+				<< ", reprojected " << stats.pixelsReprojected
+				<< ", texels shaded " << stats.texelsShaded
+				<< ", render scale " << pRenderer->GetRenderScale() << std::endl;
+			Profiler::Get().PrintSummary(std::cout);
 		}
 
-		//Save screenshot after full render
+		//Save screenshot after full render, only the copy happens here
 		if (takeScreenshot)
 		{
-			if (!pRenderer->SaveBufferToImage())
-				std::cout << "Screenshot saved!" << std::endl;
-			else
-				std::cout << "Something went wrong. Screenshot not saved!" << std::endl;
+			if (!pImageWriter->Capture(pRenderer->GetRenderTarget(), GetNumberedPath(screenshotPath, ++screenshotCount)))
+				std::cout << "Still writing earlier screenshots. Screenshot not saved!" << std::endl;
 			takeScreenshot = false;
 		}
+		for (const auto& [path, isWritten] : pImageWriter->PopResults())
+		{
+			if (isWritten)
+				std::cout << "Screenshot saved to " << path << "!" << std::endl;
+			else
+				std::cout << "Something went wrong. Screenshot " << path << " not saved!" << std::endl;
+		}
 	}
 	pTimer->Stop();
 
 	//Shutdown "framework"
+	delete pSharedFrames;
+	delete pDynamicResolution;
+	delete pFrameStream;
+	delete pImageWriter;
 	delete pRenderer;
+	delete pRenderTarget;
 	delete pTimer;
 
 	ShutDown(pWindow);
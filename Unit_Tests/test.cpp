@@ -1,5 +1,30 @@
 #include "gtest/gtest.h"
+#include "SDL_surface.h"
+#include "SDL_timer.h"
+#include "BatchRenderer.h"
+#include "Benchmark.h"
+#include "Camera.h"
+#include "DynamicResolution.h"
+#include "FrameStream.h"
+#include "Frustum.h"
+#include "ImageWriter.h"
 #include "Maths.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "Profiler.h"
+#include "Renderer.h"
+#include "SharedFrameRing.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
 
 
 namespace dae
@@ -9,4 +34,929 @@ namespace dae
 		EXPECT_TRUE(true);
 	}
 
+	// flat grid with 3 unique vertices per triangle, like Utils::ParseOBJ outputs
+	static Mesh CreateGridMesh(int size)
+	{
+		Mesh mesh{};
+		for (int y{}; y < size; ++y)
+		{
+			for (int x{}; x < size; ++x)
+			{
+				const Vector3 p0{ float(x), float(y), 0.f };
+				const Vector3 p1{ float(x + 1), float(y), 0.f };
+				const Vector3 p2{ float(x), float(y + 1), 0.f };
+				const Vector3 p3{ float(x + 1), float(y + 1), 0.f };
+				for (const Vector3& p : { p0, p2, p1, p1, p2, p3 })
+				{
+					mesh.indices.push_back(uint32_t(mesh.vertices.size()));
+					mesh.vertices.push_back(Vertex{ p, colors::White, { p.x / size, p.y / size }, -Vector3::UnitZ });
+				}
+			}
+		}
+		return mesh;
+	}
+
+	TEST(MeshOptimizer, ReducesACMRAndKeepsTriangles) {
+		Mesh mesh{ CreateGridMesh(32) };
+		const size_t indexCount{ mesh.indices.size() };
+
+		const MeshOptimizationStats stats{ MeshOptimizer::OptimizeMesh(mesh) };
+
+		EXPECT_EQ(mesh.indices.size(), indexCount);
+		EXPECT_EQ(stats.verticesAfter, size_t(33 * 33));
+		EXPECT_FLOAT_EQ(stats.acmrBefore, 3.f);
+		EXPECT_LT(stats.acmrAfter, 1.f);
+		EXPECT_LE(stats.overdrawAfter, stats.overdrawBefore + 0.01f);
+		for (uint32_t index : mesh.indices) EXPECT_LT(index, mesh.vertices.size());
+	}
+
+	TEST(MeshOptimizer, BuildsBoundedMeshlets) {
+		Mesh mesh{ CreateGridMesh(32) };
+		MeshOptimizer::OptimizeMesh(mesh);
+		MeshOptimizer::BuildMeshlets(mesh);
+
+		uint32_t triangleCount{};
+		for (const Meshlet& meshlet : mesh.meshlets)
+		{
+			EXPECT_LE(meshlet.vertexCount, MeshOptimizer::MESHLET_MAX_VERTICES);
+			EXPECT_LE(meshlet.triangleCount, MeshOptimizer::MESHLET_MAX_TRIANGLES);
+			for (uint32_t idx{}; idx < meshlet.vertexCount; ++idx)
+			{
+				const Vector3& position{ mesh.vertices[mesh.meshletVertices[meshlet.vertexOffset + idx]].position };
+				EXPECT_LE((position - meshlet.center).Magnitude(), meshlet.radius + 0.0001f);
+			}
+			// flat grid, every meshlet is a perfect cone
+			EXPECT_NEAR(meshlet.coneCutoff, 0.f, 0.001f);
+			triangleCount += meshlet.triangleCount;
+		}
+		EXPECT_EQ(triangleCount, mesh.indices.size() / 3);
+	}
+
+	TEST(MeshSimplifier, BuildsDecreasingLODChain) {
+		Mesh mesh{ CreateGridMesh(32) };
+		MeshSimplifier::BuildLODs(mesh);
+
+		ASSERT_FALSE(mesh.lods.empty());
+		size_t previousCount{ mesh.indices.size() };
+		float previousError{};
+		for (const MeshLOD& lod : mesh.lods)
+		{
+			EXPECT_LT(lod.indices.size(), previousCount);
+			EXPECT_GE(lod.error, previousError);
+			for (uint32_t index : lod.indices) EXPECT_LT(index, mesh.vertices.size());
+			previousCount = lod.indices.size();
+			previousError = lod.error;
+		}
+	}
+
+	TEST(MeshSimplifier, LODErrorIsBoundedAgainstTheFullMesh) {
+		// a wavy grid, so the levels really deviate from the full mesh
+		Mesh mesh{ CreateGridMesh(32) };
+		for (Vertex& vertex : mesh.vertices) vertex.position.z = sinf(vertex.position.x * 0.4f) * cosf(vertex.position.y * 0.3f);
+		const float maxRelativeError{ 0.01f };
+		MeshSimplifier::BuildLODs(mesh, MeshSimplifier::MAX_LOD_LEVELS, maxRelativeError);
+
+		Vector3 minBounds{ mesh.vertices[0].position };
+		Vector3 maxBounds{ minBounds };
+		for (const Vertex& vertex : mesh.vertices)
+		{
+			for (int axis{}; axis < 3; ++axis)
+			{
+				minBounds[axis] = std::min(minBounds[axis], vertex.position[axis]);
+				maxBounds[axis] = std::max(maxBounds[axis], vertex.position[axis]);
+			}
+		}
+		const float maxError{ (maxBounds - minBounds).Magnitude() * maxRelativeError };
+
+		ASSERT_FALSE(mesh.lods.empty());
+		for (const MeshLOD& lod : mesh.lods) EXPECT_LE(lod.error, maxError);
+		EXPECT_GT(mesh.lods.back().error, 0.f);
+	}
+
+	TEST(Frustum, CullsSpheres) {
+		const Matrix view{ Matrix::CreateLookAtLH(Vector3::Zero, Vector3::UnitZ, Vector3::UnitY) };
+		const Matrix projection{ Matrix::CreatePerspectiveFovLH(1.f, 1.f, 0.1f, 100.f) };
+		const Frustum frustum{ Frustum::FromMatrix(view * projection) };
+
+		EXPECT_FALSE(frustum.IsSphereOutside({ 0.f, 0.f, 10.f }, 1.f));
+		EXPECT_TRUE(frustum.IsSphereOutside({ 0.f, 0.f, -10.f }, 1.f));
+		EXPECT_TRUE(frustum.IsSphereOutside({ 0.f, 0.f, 200.f }, 1.f));
+		EXPECT_TRUE(frustum.IsSphereOutside({ 50.f, 0.f, 10.f }, 1.f));
+		EXPECT_FALSE(frustum.IsSphereOutside({ 10.5f, 0.f, 10.f }, 1.f));
+		EXPECT_TRUE(frustum.IsSphereInside({ 0.f, 0.f, 10.f }, 1.f));
+		EXPECT_FALSE(frustum.IsSphereInside({ 10.5f, 0.f, 10.f }, 1.f));
+
+		const BoundingBox box{ { -1.f, -1.f, -1.f }, { 1.f, 1.f, 1.f } };
+		EXPECT_FALSE(frustum.IsBoxOutside(box.Transformed(Matrix::CreateTranslation(0.f, 0.f, 10.f))));
+		EXPECT_TRUE(frustum.IsBoxOutside(box.Transformed(Matrix::CreateTranslation(0.f, 0.f, -10.f))));
+		EXPECT_TRUE(frustum.IsBoxOutside(box.Transformed(Matrix::CreateTranslation(50.f, 0.f, 10.f))));
+	}
+
+	TEST(Profiler, SummaryAveragesStagesThatStartLate) {
+		Profiler& profiler{ Profiler::Get() };
+		for (int frame{}; frame < 5; ++frame) profiler.EndFrame();
+
+		profiler.AddTime("Late Stage", SDL_GetPerformanceFrequency() / 100);
+		profiler.EndFrame();
+		const double milliseconds{ profiler.GetLastFrame().at("Late Stage") };
+
+		std::stringstream summary{};
+		profiler.PrintSummary(summary);
+		std::string line{};
+		while (std::getline(summary, line) && line.rfind("Late Stage", 0) != 0);
+		ASSERT_EQ(line.rfind("Late Stage", 0), 0u);
+
+		// one frame recorded, so the average is that frame
+		const double average{ std::stod(line.substr(line.find("avg ") + 4)) };
+		EXPECT_NEAR(average, milliseconds, 0.001);
+	}
+
+	TEST(ThreadPool, ParallelForVisitsEveryItemOnce) {
+		ThreadPool threadPool{ 3 };
+		std::vector<std::atomic<int>> visits(10000);
+
+		threadPool.ParallelFor(visits.size(), 64, [&visits](size_t begin, size_t end)
+			{
+				for (size_t idx{ begin }; idx < end; ++idx) ++visits[idx];
+			});
+
+		for (const std::atomic<int>& count : visits) EXPECT_EQ(count.load(), 1);
+		EXPECT_NO_THROW(threadPool.Enqueue([]() {}).get());
+	}
+
+	// plain loops over operator[], the reference the SSE path in Matrix.h has to match
+	static Matrix MultiplyReference(const Matrix& a, const Matrix& b)
+	{
+		Matrix result{};
+		for (int r{}; r < 4; ++r)
+		{
+			for (int c{}; c < 4; ++c)
+			{
+				float sum{};
+				for (int k{}; k < 4; ++k) sum += a[r][k] * b[k][c];
+				result[r][c] = sum;
+			}
+		}
+		return result;
+	}
+
+	static Vector4 TransformReference(const Matrix& m, const Vector4& v)
+	{
+		Vector4 result{};
+		for (int c{}; c < 4; ++c)
+		{
+			result[c] = v.x * m[0][c] + v.y * m[1][c] + v.z * m[2][c] + v.w * m[3][c];
+		}
+		return result;
+	}
+
+	static Matrix CreateRandomMatrix(std::mt19937& generator)
+	{
+		std::uniform_real_distribution<float> distribution{ -10.f, 10.f };
+		Matrix m{};
+		for (int r{}; r < 4; ++r)
+		{
+			for (int c{}; c < 4; ++c) m[r][c] = distribution(generator);
+		}
+		return m;
+	}
+
+	static void ExpectNear(const Vector4& a, const Vector4& b, float tolerance)
+	{
+		for (int idx{}; idx < 4; ++idx) EXPECT_NEAR(a[idx], b[idx], tolerance);
+	}
+
+	TEST(Matrix, MatchesScalarReference) {
+		std::mt19937 generator{ 31 };
+		std::uniform_real_distribution<float> distribution{ -10.f, 10.f };
+
+		for (int iteration{}; iteration < 100; ++iteration)
+		{
+			const Matrix a{ CreateRandomMatrix(generator) };
+			const Matrix b{ CreateRandomMatrix(generator) };
+
+			const Matrix product{ a * b };
+			const Matrix reference{ MultiplyReference(a, b) };
+			Matrix inPlace{ a };
+			inPlace *= b;
+			for (int r{}; r < 4; ++r)
+			{
+				ExpectNear(product[r], reference[r], 1e-3f);
+				ExpectNear(inPlace[r], reference[r], 1e-3f);
+				for (int c{}; c < 4; ++c) EXPECT_EQ(Matrix::Transpose(a)[r][c], a[c][r]);
+			}
+
+			const Vector4 v{ distribution(generator), distribution(generator), distribution(generator), distribution(generator) };
+			ExpectNear(a.TransformPoint(v), TransformReference(a, v), 1e-3f);
+			ExpectNear(a.TransformPoint(v.x, v.y, v.z, v.w), TransformReference(a, v), 1e-3f);
+
+			const Vector3 point{ a.TransformPoint(v.GetXYZ()) };
+			const Vector3 vector{ a.TransformVector(v.GetXYZ()) };
+			ExpectNear({ point, 0.f }, { TransformReference(a, { v.GetXYZ(), 1.f }).GetXYZ(), 0.f }, 1e-3f);
+			ExpectNear({ vector, 0.f }, { TransformReference(a, { v.GetXYZ(), 0.f }).GetXYZ(), 0.f }, 1e-3f);
+		}
+	}
+
+	TEST(Matrix, InverseOfProjectiveMatrix) {
+		const Matrix m{ Matrix::CreateLookAtLH({ 1.f, 2.f, -5.f }, { 0.f, 0.f, 1.f }, Vector3::UnitY)
+			* Matrix::CreatePerspectiveFovLH(1.f, 1.5f, 0.1f, 100.f) };
+
+		const Matrix identity{ m * Matrix::Inverse(m) };
+		for (int r{}; r < 4; ++r)
+		{
+			for (int c{}; c < 4; ++c) EXPECT_NEAR(identity[r][c], r == c ? 1.f : 0.f, 1e-4f);
+		}
+	}
+
+	TEST(Matrix, BatchedTransformsMatchSingleTransforms) {
+		std::mt19937 generator{ 32 };
+		std::uniform_real_distribution<float> distribution{ -10.f, 10.f };
+		const Matrix m{ Matrix::CreateLookAtLH({ 1.f, 2.f, -30.f }, { 0.f, 0.f, 1.f }, Vector3::UnitY)
+			* Matrix::CreatePerspectiveFovLH(1.f, 1.5f, 0.1f, 100.f) };
+
+		// not a multiple of 4 so the scalar tail of the SoA path runs too
+		constexpr size_t count{ 11 };
+		std::vector<Vector3> points(count);
+		std::vector<float> x(count), y(count), z(count);
+		for (size_t idx{}; idx < count; ++idx)
+		{
+			points[idx] = { distribution(generator), distribution(generator), distribution(generator) };
+			x[idx] = points[idx].x;
+			y[idx] = points[idx].y;
+			z[idx] = points[idx].z;
+		}
+
+		std::vector<Vector3> pointsOut(count), vectorsOut(count);
+		std::vector<Vector4> projected(count);
+		m.TransformPoints(points, pointsOut);
+		m.TransformVectors(points, vectorsOut);
+		m.TransformPoints(points, projected, true);
+
+		std::vector<float> outX(count), outY(count), outZ(count), outW(count);
+		m.TransformPoints({ x, y, z }, { outX, outY, outZ, outW }, true);
+
+		for (size_t idx{}; idx < count; ++idx)
+		{
+			Vector4 expected{ m.TransformPoint(Vector4{ points[idx], 1.f }) };
+			expected = { expected.x / expected.w, expected.y / expected.w, expected.z / expected.w, expected.w };
+
+			EXPECT_EQ(pointsOut[idx], m.TransformPoint(points[idx]));
+			EXPECT_EQ(vectorsOut[idx], m.TransformVector(points[idx]));
+			ExpectNear(projected[idx], expected, 1e-5f);
+			ExpectNear({ outX[idx], outY[idx], outZ[idx], outW[idx] }, expected, 1e-5f);
+		}
+
+		m.TransformVectors({ x, y, z }, { x, y, z });
+		for (size_t idx{}; idx < count; ++idx)
+		{
+			EXPECT_EQ(Vector3(x[idx], y[idx], z[idx]), vectorsOut[idx]);
+		}
+	}
+
+	// a failing static_assert breaks the build, the runtime checks make sure the SSE path agrees
+	constexpr Matrix CompileTimeViewProjection{ Matrix::CreateLookAtLH({ 0.f, 0.f, -10.f }, Vector3::UnitZ, Vector3::UnitY)
+		* Matrix::CreatePerspectiveFovLH(1.f, 1.f, 0.1f, 100.f) };
+
+	static_assert(Vector3::Cross(Vector3::UnitX, Vector3::UnitY) == Vector3::UnitZ);
+	static_assert(Vector3::Dot(Vector3{ 1.f, 2.f, 3.f }, Vector3{ 4.f, 5.f, 6.f }) == 32.f);
+	static_assert(AreEqual(Vector3{ 3.f, 4.f, 0.f }.Magnitude(), 5.f));
+	static_assert(Vector3{ 0.f, 0.f, 2.f }.Normalized() == Vector3::UnitZ);
+	static_assert(Vector2{ 1.f, 2.f } + Vector2{ 3.f, 4.f } == Vector2{ 4.f, 6.f });
+	static_assert(Vector4{ Vector3::UnitX, 1.f }.GetXYZ() == Vector3::UnitX);
+	static_assert((colors::Yellow * colors::Cyan).g == 1.f && (colors::Yellow * colors::Cyan).r == 0.f);
+	static_assert(Clamp(2.f, 0.f, 1.f) == 1.f && Square(3.f) == 9.f);
+
+	static_assert((Matrix::CreateTranslation(1.f, 2.f, 3.f) * Matrix::CreateScale(2.f, 2.f, 2.f)).TransformPoint(Vector3{ 1.f, 1.f, 1.f }) == Vector3{ 4.f, 6.f, 8.f });
+	static_assert(Matrix::Inverse(Matrix::CreateTranslation(1.f, 2.f, 3.f)) == Matrix::CreateTranslation(-1.f, -2.f, -3.f));
+	static_assert(Matrix::Transpose(Matrix::CreateTranslation(1.f, 2.f, 3.f))[0][3] == 1.f);
+	// a point on the view axis lands in the center of NDC
+	static_assert(AreEqual(CompileTimeViewProjection.TransformPoint(Vector4{ 0.f, 0.f, 5.f, 1.f }).x, 0.f));
+	static_assert(CompileTimeViewProjection.TransformPoint(Vector4{ 0.f, 0.f, 5.f, 1.f }).w == 15.f);
+
+	TEST(Constexpr, MatchesRuntimeEvaluation) {
+		const Matrix view{ Matrix::CreateLookAtLH({ 0.f, 0.f, -10.f }, Vector3::UnitZ, Vector3::UnitY) };
+		const Matrix projection{ Matrix::CreatePerspectiveFovLH(1.f, 1.f, 0.1f, 100.f) };
+		const Matrix runtimeViewProjection{ view * projection };
+
+		for (int r{}; r < 4; ++r)
+		{
+			ExpectNear(runtimeViewProjection[r], CompileTimeViewProjection[r], 1e-6f);
+		}
+
+		constexpr Vector4 compileTimePoint{ CompileTimeViewProjection.TransformPoint(Vector4{ 1.f, 2.f, 3.f, 1.f }) };
+		ExpectNear(runtimeViewProjection.TransformPoint(Vector4{ 1.f, 2.f, 3.f, 1.f }), compileTimePoint, 1e-5f);
+	}
+
+	TEST(Camera, MatricesOnlyRebuildWhenInputsChange) {
+		Camera camera{};
+		camera.Initialize(1.5f, 45.f, { 0.f, 5.f, -64.f });
+		camera.CalculateViewMatrix();
+		camera.CalculateProjectionMatrix();
+		const uint32_t version{ camera.version };
+		EXPECT_EQ(version, 2u);
+
+		// nothing moved and fov and aspect are the same
+		camera.CalculateViewMatrix();
+		camera.CalculateProjectionMatrix();
+		EXPECT_EQ(camera.version, version);
+
+		camera.aspectRatio = 2.f;
+		camera.CalculateProjectionMatrix();
+		EXPECT_EQ(camera.version, version + 1);
+
+		camera.origin.x += 1.f;
+		camera.updateONB = true;
+		camera.CalculateViewMatrix();
+		EXPECT_EQ(camera.version, version + 2);
+		EXPECT_EQ(camera.viewMatrix.TransformPoint(camera.origin), Vector3::Zero);
+	}
+
+	// Golden images and the frame time baselines are stored in References next to this file. A missing golden image fails,
+	// a missing baseline skips the check. Set RASTERIZER_UPDATE_REFERENCES to write them, after an intended visual change
+	// or to record the baseline of a new CI runner type.
+#ifndef UNIT_TESTS_DIRECTORY
+#define UNIT_TESTS_DIRECTORY ""
+#endif
+	static const std::string REFERENCE_DIRECTORY{ std::string{ UNIT_TESTS_DIRECTORY } + "References/" };
+
+	static float GetEnvironmentFloat(const char* pName, float defaultValue)
+	{
+		const char* pValue{ std::getenv(pName) };
+		return pValue ? float(std::atof(pValue)) : defaultValue;
+	}
+
+	static bool IsUpdatingReferences()
+	{
+		return std::getenv("RASTERIZER_UPDATE_REFERENCES") != nullptr;
+	}
+
+	// pixels with any channel further than tolerance away from the reference, -1 when the sizes don't match
+	static int CountDifferentPixels(const RenderTarget& image, SDL_Surface* pReference, int tolerance)
+	{
+		if (image.GetWidth() != pReference->w || image.GetHeight() != pReference->h) return -1;
+
+		SDL_Surface* pConverted{ SDL_ConvertSurfaceFormat(pReference, SDL_PIXELFORMAT_RGB888, 0) };
+		int differentPixels{};
+		for (int y{}; y < image.GetHeight(); ++y)
+		{
+			const uint32_t* pReferenceRow{ (const uint32_t*)((const uint8_t*)pConverted->pixels + y * pConverted->pitch) };
+			for (int x{}; x < image.GetWidth(); ++x)
+			{
+				uint8_t r0{}, g0{}, b0{}, r1{}, g1{}, b1{};
+				RenderTarget::GetRGB(image.GetRow(y)[x], r0, g0, b0);
+				RenderTarget::GetRGB(pReferenceRow[x], r1, g1, b1);
+				if (std::abs(r0 - r1) > tolerance || std::abs(g0 - g1) > tolerance || std::abs(b0 - b1) > tolerance) ++differentPixels;
+			}
+		}
+		SDL_FreeSurface(pConverted);
+		return differentPixels;
+	}
+
+	// mean absolute difference over every channel of every pixel, both targets have the same size
+	static double MeanChannelDifference(const RenderTarget& image, const RenderTarget& reference)
+	{
+		double difference{};
+		for (int y{}; y < image.GetHeight(); ++y)
+		{
+			for (int x{}; x < image.GetWidth(); ++x)
+			{
+				uint8_t r0{}, g0{}, b0{}, r1{}, g1{}, b1{};
+				RenderTarget::GetRGB(image.GetRow(y)[x], r0, g0, b0);
+				RenderTarget::GetRGB(reference.GetRow(y)[x], r1, g1, b1);
+				difference += std::abs(r0 - r1) + std::abs(g0 - g1) + std::abs(b0 - b1);
+			}
+		}
+		return difference / (double(image.GetWidth()) * image.GetHeight() * 3);
+	}
+
+	// a renderer under test next to a reference renderer with default settings, sharing the given meshes
+	struct RendererComparison
+	{
+		explicit RendererComparison(std::vector<Mesh> meshes) : resources{ std::move(meshes) } {};
+
+		void LookAt(const Vector3& origin, const Vector3& target)
+		{
+			reference.GetCamera().LookAt(origin, target);
+			renderer.GetCamera().LookAt(origin, target);
+		}
+
+		void Render(float deltaTime)
+		{
+			for (Renderer* pRenderer : { &reference, &renderer })
+			{
+				pRenderer->Update(deltaTime);
+				pRenderer->Render();
+			}
+		}
+
+		double MeanDifference() const { return MeanChannelDifference(renderTarget, referenceTarget); };
+
+		RendererResources resources;
+		MemoryRenderTarget referenceTarget{ 160, 120 };
+		MemoryRenderTarget renderTarget{ 160, 120 };
+		Renderer reference{ &referenceTarget, &resources, 0 };
+		Renderer renderer{ &renderTarget, &resources, 0 };
+	};
+
+	static const std::pair<const char*, Renderer::ShadingMode> SHADING_MODES[]{
+		{ "ObservedArea", Renderer::ShadingMode::ObservedAreaOnly },
+		{ "Diffuse", Renderer::ShadingMode::Diffuse },
+		{ "Specular", Renderer::ShadingMode::Specular },
+		{ "Combined", Renderer::ShadingMode::Combined } };
+
+	static void ExpectMatchesReference(const RenderTarget& image, const std::string& path)
+	{
+		if (IsUpdatingReferences())
+		{
+			std::filesystem::create_directories(REFERENCE_DIRECTORY);
+			EXPECT_TRUE(image.SaveToBMP(path)) << "could not write the reference";
+			return;
+		}
+
+		SDL_Surface* pReference{ SDL_LoadBMP(path.c_str()) };
+		if (!pReference)
+		{
+			ADD_FAILURE() << "missing reference " << path << ", run once with RASTERIZER_UPDATE_REFERENCES set to write it";
+			return;
+		}
+
+		// per channel difference that still counts as equal, and the share of pixels allowed to differ more (triangle edges)
+		const int tolerance{ int(GetEnvironmentFloat("RASTERIZER_PIXEL_TOLERANCE", 2.f)) };
+		const float maxDifferentPixels{ GetEnvironmentFloat("RASTERIZER_MAX_DIFFERENT_PIXELS", 0.001f) };
+
+		const int differentPixels{ CountDifferentPixels(image, pReference, tolerance) };
+		SDL_FreeSurface(pReference);
+
+		ASSERT_GE(differentPixels, 0) << "reference has a different resolution";
+		EXPECT_LE(differentPixels, int(maxDifferentPixels * image.GetWidth() * image.GetHeight()));
+	}
+
+	// only built from what is in the tree, so its golden images can be checked in
+	static Mesh CreateSphereMesh(int rings, int segments, float radius)
+	{
+		Mesh mesh{};
+		for (int ring{}; ring <= rings; ++ring)
+		{
+			const float theta{ PI * ring / rings };
+			for (int segment{}; segment <= segments; ++segment)
+			{
+				const float phi{ PI_2 * segment / segments };
+				const Vector3 normal{ sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi) };
+				const Vector3 tangent{ -sinf(phi), 0.f, cosf(phi) };
+				mesh.vertices.push_back(Vertex{ normal * radius, colors::White, { float(segment) / segments, float(ring) / rings }, normal, tangent });
+			}
+		}
+		for (int ring{}; ring < rings; ++ring)
+		{
+			for (int segment{}; segment < segments; ++segment)
+			{
+				const uint32_t i0{ uint32_t(ring * (segments + 1) + segment) };
+				const uint32_t i1{ i0 + 1 };
+				const uint32_t i2{ i0 + uint32_t(segments + 1) };
+				const uint32_t i3{ i2 + 1 };
+				for (uint32_t index : { i0, i1, i2, i1, i3, i2 }) mesh.indices.push_back(index);
+			}
+		}
+		return mesh;
+	}
+
+	TEST(GoldenImage, SphereMatchesReferenceInEveryShadingMode) {
+		const RendererResources resources{ std::vector<Mesh>{ CreateSphereMesh(24, 48, 10.f) } };
+		MemoryRenderTarget renderTarget{ 160, 120 };
+		Renderer renderer{ &renderTarget, &resources, 0 };
+		renderer.ToggleRotation();
+		renderer.GetCamera().LookAt({ 12.f, 8.f, -30.f }, Vector3::Zero);
+
+		for (const auto& [pModeName, shadingMode] : SHADING_MODES)
+		{
+			const std::string path{ REFERENCE_DIRECTORY + "Sphere_" + pModeName + ".bmp" };
+			SCOPED_TRACE(path);
+
+			renderer.SetShadingMode(shadingMode);
+			renderer.Update(0.f);
+			renderer.Render();
+			ASSERT_GT(renderer.GetFrameStatistics().trianglesRasterized, 0u) << "nothing rendered";
+
+			ExpectMatchesReference(renderTarget, path);
+		}
+	}
+
+	TEST(Performance, FrameTimeWithinBaseline) {
+		const RendererResources resources{ std::vector<Mesh>{ CreateSphereMesh(48, 96, 10.f) } };
+		MemoryRenderTarget renderTarget{ 640, 480 };
+		Renderer renderer{ &renderTarget, &resources, 0 };
+
+		BenchmarkOptions options{};
+		options.warmupFrames = 20;
+		options.measuredFrames = 120;
+		const BenchmarkResult result{ Benchmark::Run(&renderer, options) };
+		ASSERT_GT(result.trianglesRasterized, 0.0);
+		RecordProperty("frameTimeP50", std::to_string(result.frameTime.p50));
+
+		// the median is far less noisy than the mean on shared machines, debug builds are too slow to share a baseline
+#ifdef NDEBUG
+		const std::string path{ REFERENCE_DIRECTORY + "FrameTimeBaseline.txt" };
+#else
+		const std::string path{ REFERENCE_DIRECTORY + "FrameTimeBaseline_Debug.txt" };
+#endif
+		if (IsUpdatingReferences())
+		{
+			std::filesystem::create_directories(REFERENCE_DIRECTORY);
+			std::ofstream output{ path };
+			output << result.frameTime.p50 << std::endl;
+			EXPECT_TRUE(bool(output)) << "could not write " << path;
+			return;
+		}
+
+		// baselines are machine specific, keep one per CI runner type
+		double baseline{};
+		std::ifstream input{ path };
+		if (!(input >> baseline))
+		{
+			// gtest 1.8 can't skip, so the report says the comparison didn't run instead of the test silently passing
+			RecordProperty("frameTimeBaseline", "missing");
+			std::cout << "no frame time baseline at " << path << ", the regression check did not run. Run once with RASTERIZER_UPDATE_REFERENCES set to record one" << std::endl;
+			return;
+		}
+		RecordProperty("frameTimeBaseline", std::to_string(baseline));
+
+		const double margin{ GetEnvironmentFloat("RASTERIZER_PERF_MARGIN", 0.25f) };
+		EXPECT_LE(result.frameTime.p50, baseline * (1.0 + margin)) << "median frame time regressed against " << path;
+	}
+
+	TEST(BatchRenderer, JobsProduceTheSameFramesAsOneJob) {
+		const RendererResources resources{ std::vector<Mesh>{ CreateSphereMesh(24, 48, 10.f) } };
+		const std::vector<BatchFrame> frames{ BatchRenderer::CreateTurntable(6) };
+
+		const std::filesystem::path directory{ std::filesystem::temp_directory_path() / "RasterizerBatchTest" };
+		BatchOptions singleOptions{ (directory / "Single").string(), 1 };
+		BatchOptions parallelOptions{ (directory / "Parallel").string(), 3 };
+
+		const BatchResult single{ BatchRenderer::Run(&resources, 160, 120, frames, singleOptions) };
+		const BatchResult parallel{ BatchRenderer::Run(&resources, 160, 120, frames, parallelOptions) };
+		EXPECT_EQ(single.framesRendered, 6);
+		EXPECT_EQ(parallel.framesRendered, 6);
+		EXPECT_EQ(parallel.jobCount, 3);
+		ASSERT_GT(single.trianglesRasterized, 0u);
+		EXPECT_EQ(parallel.trianglesRasterized, single.trianglesRasterized);
+
+		for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator{ singleOptions.outputDirectory })
+		{
+			SCOPED_TRACE(entry.path().string());
+			std::ifstream singleFile{ entry.path(), std::ios::binary };
+			std::ifstream parallelFile{ std::filesystem::path{ parallelOptions.outputDirectory } / entry.path().filename(), std::ios::binary };
+			ASSERT_TRUE(parallelFile.is_open());
+			EXPECT_TRUE(std::equal(std::istreambuf_iterator<char>{ singleFile }, {}, std::istreambuf_iterator<char>{ parallelFile }, {}));
+		}
+		std::filesystem::remove_all(directory);
+	}
+
+	TEST(SwapChainRenderTarget, EveryFrameMatchesSingleBuffer) {
+		const RendererResources resources{ std::vector<Mesh>{ CreateSphereMesh(24, 48, 10.f) } };
+		MemoryRenderTarget singleTarget{ 160, 120 };
+		SwapChainRenderTarget swapChainTarget{ 160, 120, nullptr, 3 };
+		Renderer singleRenderer{ &singleTarget, &resources, 0 };
+		Renderer swapChainRenderer{ &swapChainTarget, &resources, 0 };
+
+		// the sphere turns, so every frame only redraws a dirty rectangle on top of an older buffer,
+		// frames 4 and 5 stand still and hand over an empty rectangle
+		for (int frame{}; frame < 10; ++frame)
+		{
+			const bool isIdle{ frame == 4 || frame == 5 };
+			if (frame == 4 || frame == 6)
+			{
+				singleRenderer.ToggleRotation();
+				swapChainRenderer.ToggleRotation();
+			}
+			singleRenderer.Update(0.1f);
+			swapChainRenderer.Update(0.1f);
+			singleRenderer.Render();
+			swapChainRenderer.Render();
+
+			const FrameStatistics& stats{ swapChainRenderer.GetFrameStatistics() };
+			if (isIdle)
+				ASSERT_EQ(stats.pixelsRedrawn, 0u) << "frame " << frame;
+			else
+				ASSERT_GT(stats.trianglesRasterized, 0u) << "frame " << frame;
+
+			for (int y{}; y < 120; ++y)
+			{
+				ASSERT_TRUE(std::equal(singleTarget.GetRow(y), singleTarget.GetRow(y) + 160, swapChainTarget.GetRow(y))) << "frame " << frame << ", row " << y;
+			}
+		}
+		swapChainTarget.Flush();
+	}
+
+	TEST(ImageWriter, EncodesQOIAndPPM) {
+		// stride 3, the third pixel of each row is padding
+		const uint32_t pixels[]{ 0x000000, 0xff0000, 0xdeadbe, 0x000000, 0x000000, 0xdeadbe };
+
+		const std::vector<uint8_t> qoi{ ImageWriter::EncodeQOI(pixels, 2, 2, 3) };
+		const std::vector<uint8_t> expectedQOI{ 'q', 'o', 'i', 'f', 0, 0, 0, 2, 0, 0, 0, 2, 3, 0,
+			0xc0, // black repeats the implicit previous pixel
+			0x5a, // red is a -1 difference in red from black
+			0x7a, // back to black is +1 in red, black never went into the index because it was a run
+			0xc0, // one more black
+			0, 0, 0, 0, 0, 0, 0, 1 };
+		EXPECT_EQ(qoi, expectedQOI);
+
+		const std::vector<uint8_t> ppm{ ImageWriter::EncodePPM(pixels, 2, 2, 3) };
+		const std::string header{ "P6\n2 2\n255\n" };
+		ASSERT_EQ(ppm.size(), header.size() + 12);
+		EXPECT_TRUE(std::equal(header.begin(), header.end(), ppm.begin()));
+		EXPECT_EQ(ppm[header.size() + 3], 0xff);
+		EXPECT_EQ(ppm[header.size() + 4], 0x00);
+
+		EXPECT_EQ(ImageWriter::GetFormat("Shot.PNG"), ImageFormat::PNG);
+		EXPECT_EQ(ImageWriter::GetFormat("Shot.qoi"), ImageFormat::QOI);
+		EXPECT_EQ(ImageWriter::GetFormat("Shot"), ImageFormat::BMP);
+	}
+
+	TEST(ImageWriter, AsyncCapturesAreWrittenAndDroppedWhenThePoolIsFull) {
+		MemoryRenderTarget renderTarget{ 64, 32 };
+		renderTarget.Fill({ 0, 0, 64, 32 }, RenderTarget::MapRGB(10, 20, 30));
+
+		const std::filesystem::path directory{ std::filesystem::temp_directory_path() / "RasterizerImageWriterTest" };
+		std::filesystem::create_directories(directory);
+		{
+			AsyncImageWriter writer{ 1 };
+			int capturedCount{};
+			for (int idx{}; idx < 8; ++idx)
+			{
+				if (writer.Capture(renderTarget, (directory / ("Shot_" + std::to_string(idx) + ".ppm")).string())) ++capturedCount;
+			}
+			writer.Flush();
+
+			const std::vector<std::pair<std::string, bool>> results{ writer.PopResults() };
+			EXPECT_GE(capturedCount, 1);
+			ASSERT_EQ(int(results.size()), capturedCount);
+			for (const auto& [path, isWritten] : results)
+			{
+				EXPECT_TRUE(isWritten);
+				EXPECT_EQ(std::filesystem::file_size(path), std::string{ "P6\n64 32\n255\n" }.size() + 64 * 32 * 3);
+			}
+			EXPECT_TRUE(writer.PopResults().empty());
+		}
+		std::filesystem::remove_all(directory);
+	}
+
+	TEST(FrameStream, ConvertsToYUV420AndRGBA) {
+		// odd size so the vector loops leave a scalar tail and the last chroma samples cover a single column and row
+		const int width{ 13 }, height{ 5 };
+		std::mt19937 generator{ 7 };
+		std::vector<uint32_t> pixels(width * height);
+		for (uint32_t& pixel : pixels) pixel = generator() & 0xffffff;
+
+		std::vector<uint8_t> yuv(width * height + 2 * 7 * 3);
+		FrameStreamWriter::ConvertToYUV420(pixels.data(), width, height, width, yuv.data(), yuv.data() + width * height, yuv.data() + width * height + 7 * 3);
+		for (int idx{}; idx < width * height; ++idx)
+		{
+			uint8_t r{}, g{}, b{};
+			RenderTarget::GetRGB(pixels[idx], r, g, b);
+			EXPECT_EQ(yuv[idx], ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16) << "pixel " << idx;
+		}
+		// last chroma sample only averages pixel (12, 4) with itself
+		uint8_t r{}, g{}, b{};
+		RenderTarget::GetRGB(pixels[4 * width + 12], r, g, b);
+		EXPECT_EQ(yuv.back(), ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+
+		std::vector<uint8_t> rgba(width * height * 4);
+		FrameStreamWriter::ConvertToRGBA(pixels.data(), width, height, width, rgba.data());
+		for (int idx : { 0, 3, 4, width * height - 1 })
+		{
+			RenderTarget::GetRGB(pixels[idx], r, g, b);
+			EXPECT_EQ(rgba[idx * 4], r);
+			EXPECT_EQ(rgba[idx * 4 + 1], g);
+			EXPECT_EQ(rgba[idx * 4 + 2], b);
+			EXPECT_EQ(rgba[idx * 4 + 3], 255);
+		}
+	}
+
+	TEST(FrameStream, WritesEveryFrameAsY4M) {
+		MemoryRenderTarget renderTarget{ 32, 16 };
+		const std::filesystem::path path{ std::filesystem::temp_directory_path() / "RasterizerFrameStreamTest.y4m" };
+		{
+			FrameStreamWriter stream{ path.string(), FrameStreamFormat::Y4M, 32, 16, 30, 2 };
+			ASSERT_TRUE(stream.IsOpen());
+			for (int frame{}; frame < 10; ++frame)
+			{
+				renderTarget.Fill({ 0, 0, 32, 16 }, RenderTarget::MapRGB(uint8_t(frame * 20), 0, 0));
+				EXPECT_TRUE(stream.Submit(renderTarget));
+			}
+			stream.Flush();
+			EXPECT_EQ(stream.GetFramesWritten(), 10);
+		}
+
+		const std::string header{ "YUV4MPEG2 W32 H16 F30:1 Ip A1:1 C420jpeg\n" };
+		EXPECT_EQ(std::filesystem::file_size(path), header.size() + 10 * (6 + 32 * 16 + 2 * 16 * 8));
+		std::filesystem::remove(path);
+	}
+
+	TEST(SharedFrameRing, ReaderSeesTheLatestPublishedFrame) {
+		const std::string name{ "RasterizerSharedFrameRingTest" };
+		MemoryRenderTarget renderTarget{ 16, 8 };
+		SharedFrameRingWriter writer{ name, 16, 8, 3 };
+		ASSERT_TRUE(writer.IsOpen());
+
+		SharedFrameRingReader reader{ name };
+		ASSERT_TRUE(reader.IsOpen());
+		EXPECT_EQ(reader.GetWidth(), 16);
+		EXPECT_EQ(reader.GetHeight(), 8);
+
+		uint64_t frame{};
+		std::vector<uint32_t> copy(16 * 8);
+		const auto copyPixels{ [&copy, &reader](const uint32_t* pPixels)
+			{
+				for (int y{}; y < 8; ++y) std::copy(pPixels + y * reader.GetStride(), pPixels + y * reader.GetStride() + 16, copy.data() + y * 16);
+			} };
+		EXPECT_FALSE(reader.ReadLatest(frame, copyPixels));
+
+		// the first frame fills the target, later ones only change a corner
+		renderTarget.Fill({ 0, 0, 16, 8 }, 0x112233);
+		writer.Publish(renderTarget, { 0, 0, 16, 8 });
+		for (int idx{ 1 }; idx <= 4; ++idx)
+		{
+			renderTarget.Fill({ 0, 0, 2, 2 }, 0x000100 * idx);
+			writer.Publish(renderTarget, { 0, 0, 2, 2 });
+		}
+
+		ASSERT_TRUE(reader.ReadLatest(frame, copyPixels));
+		EXPECT_EQ(frame, 5u);
+		EXPECT_EQ(copy[0], 0x000400u);
+		EXPECT_EQ(copy[17], 0x000400u);
+		EXPECT_EQ(copy[2], 0x112233u);
+		EXPECT_EQ(copy[16 * 8 - 1], 0x112233u);
+		EXPECT_FALSE(reader.ReadLatest(frame, copyPixels)) << "nothing newer was published";
+	}
+
+	TEST(SharedFrameRing, ReaderRejectsAnEmptyFrameSize) {
+		const std::string name{ "RasterizerSharedFrameRingEmptyTest" };
+		SharedFrameRingWriter writer{ name, 0, 8 };
+		ASSERT_TRUE(writer.IsOpen());
+
+		const SharedFrameRingReader reader{ name };
+		EXPECT_FALSE(reader.IsOpen());
+	}
+
+	TEST(DynamicResolution, ScalesDownWhenSlowAndBackUpWithHeadroom) {
+		DynamicResolution dynamicResolution{ 10.f, 0.5f, 1.f };
+		for (int frame{}; frame < 200; ++frame) dynamicResolution.Update(40.f * dynamicResolution.GetScale() * dynamicResolution.GetScale());
+		EXPECT_LE(dynamicResolution.GetScale(), 0.5625f);
+		EXPECT_GE(dynamicResolution.GetScale(), 0.5f);
+
+		for (int frame{}; frame < 500; ++frame) dynamicResolution.Update(4.f * dynamicResolution.GetScale() * dynamicResolution.GetScale());
+		EXPECT_FLOAT_EQ(dynamicResolution.GetScale(), 1.f);
+	}
+
+	TEST(RenderTarget, UpscaleBilinearKeepsCornersAndBlendsBetween) {
+		MemoryRenderTarget source{ 2, 1 };
+		source.GetRow(0)[0] = RenderTarget::MapRGB(0, 0, 0);
+		source.GetRow(0)[1] = RenderTarget::MapRGB(200, 100, 40);
+		MemoryRenderTarget destination{ 4, 2 };
+		RenderTarget::UpscaleBilinear(source, destination, { 0, 0, 4, 2 });
+
+		for (int y{}; y < 2; ++y)
+		{
+			EXPECT_EQ(destination.GetRow(y)[0], source.GetRow(0)[0]);
+			EXPECT_EQ(destination.GetRow(y)[3], source.GetRow(0)[1]);
+			// a quarter of the way from the left texel to the right one
+			uint8_t r{}, g{}, b{};
+			RenderTarget::GetRGB(destination.GetRow(y)[1], r, g, b);
+			EXPECT_NEAR(r, 50, 1);
+			EXPECT_NEAR(g, 25, 1);
+			EXPECT_NEAR(b, 10, 1);
+		}
+	}
+
+	TEST(Renderer, RendersAtReducedScaleIntoTheFullTarget) {
+		const RendererResources resources{ std::vector<Mesh>{ CreateSphereMesh(24, 48, 10.f) } };
+		MemoryRenderTarget renderTarget{ 160, 120 };
+		Renderer renderer{ &renderTarget, &resources, 0 };
+		renderer.ToggleRotation();
+		renderer.Update(0.f);
+		renderer.Render();
+		const std::vector<uint32_t> fullFrame(renderTarget.GetRow(60), renderTarget.GetRow(60) + 160);
+
+		renderer.SetRenderScale(0.5f);
+		EXPECT_EQ(renderer.GetWidth(), 80);
+		EXPECT_EQ(renderer.GetHeight(), 60);
+		renderer.Update(0.f);
+		renderer.Render();
+		EXPECT_GT(renderer.GetFrameStatistics().trianglesRasterized, 0u);
+		EXPECT_EQ(renderer.GetFrameStatistics().pixelsRedrawn, 80u * 60u);
+		EXPECT_EQ(renderer.GetDirtyRect().GetArea(), 160u * 120u);
+
+		// the background reaches the edges at both scales
+		EXPECT_EQ(renderTarget.GetRow(60)[0], fullFrame[0]);
+		EXPECT_EQ(renderTarget.GetRow(0)[159], RenderTarget::MapRGB(100, 100, 100));
+
+		renderer.SetRenderScale(1.f);
+		renderer.Update(0.f);
+		renderer.Render();
+		EXPECT_TRUE(std::equal(fullFrame.begin(), fullFrame.end(), renderTarget.GetRow(60)));
+	}
+
+	TEST(Renderer, CoarseShadingShadesFewerPixelsAtTheSameCoverage) {
+		RendererComparison comparison{ std::vector<Mesh>{ CreateSphereMesh(24, 48, 10.f) } };
+		comparison.reference.ToggleRotation();
+		comparison.renderer.ToggleRotation();
+		comparison.renderer.ToggleCoarseShading();
+		comparison.Render(0.f);
+
+		const FrameStatistics& fullRate{ comparison.reference.GetFrameStatistics() };
+		const FrameStatistics& coarse{ comparison.renderer.GetFrameStatistics() };
+		EXPECT_EQ(fullRate.shadingInvocations, fullRate.fragments);
+		EXPECT_EQ(coarse.fragments, fullRate.fragments);
+		EXPECT_LT(coarse.shadingInvocations, coarse.fragments * 9 / 10);
+
+		// depth is still tested per pixel, so only the shading inside blocks differs a little
+		EXPECT_LT(comparison.MeanDifference(), 2.0);
+	}
+
+	TEST(Renderer, TemporalReuseReprojectsTheRotatingMesh) {
+		RendererComparison comparison{ std::vector<Mesh>{ CreateSphereMesh(24, 48, 10.f) } };
+		Renderer& renderer{ comparison.renderer };
+		renderer.ToggleTemporalReuse();
+
+		double difference{};
+		for (int frame{}; frame < 8; ++frame)
+		{
+			comparison.Render(1 / 60.f);
+			difference += comparison.MeanDifference();
+		}
+
+		// every fragment is either shaded or reprojected, most of them are reprojected
+		const FrameStatistics& stats{ renderer.GetFrameStatistics() };
+		EXPECT_EQ(stats.shadingInvocations + stats.pixelsReprojected, stats.fragments);
+		EXPECT_GT(stats.pixelsReprojected, stats.fragments / 2);
+		EXPECT_LT(difference / 8, 1.0);
+
+		// the mesh turns around the vertical axis, so it moves sideways on screen
+		const std::vector<Vector2>& motionVectors{ renderer.GetMotionVectors() };
+		EXPECT_TRUE(std::any_of(motionVectors.begin(), motionVectors.end(), [](const Vector2& motion) { return std::abs(motion.x) > 0.01f; }));
+
+		// a different shading mode can't reuse anything
+		renderer.CycleShadingMode();
+		renderer.Update(1 / 60.f);
+		renderer.Render();
+		EXPECT_EQ(renderer.GetFrameStatistics().pixelsReprojected, 0u);
+	}
+
+	TEST(Renderer, TextureSpaceShadingReusesTexelsWhileTheMeshStandsStill) {
+		RendererComparison comparison{ std::vector<Mesh>{ CreateSphereMesh(24, 48, 10.f) } };
+		Renderer& renderer{ comparison.renderer };
+		comparison.reference.ToggleRotation();
+		renderer.ToggleRotation();
+		renderer.ToggleTextureSpaceShading();
+
+		// only the camera moves, the cached lighting stays valid
+		for (int frame{}; frame < 3; ++frame)
+		{
+			comparison.LookAt(Vector3{ frame * 2.f, 5.f, -64.f }, Vector3{ 0.f, 5.f, 0.f });
+			comparison.Render(0.f);
+		}
+		const FrameStatistics& stats{ renderer.GetFrameStatistics() };
+		EXPECT_EQ(stats.shadingInvocations, stats.fragments);
+		EXPECT_LT(stats.texelsShaded, stats.fragments / 4);
+		EXPECT_LT(comparison.MeanDifference(), 1.0);
+
+		// turning the mesh changes how every texel is lit
+		renderer.ToggleRotation();
+		renderer.Update(0.1f);
+		renderer.Render();
+		EXPECT_GT(renderer.GetFrameStatistics().texelsShaded, renderer.GetFrameStatistics().fragments / 4);
+	}
+
+	TEST(Renderer, TextureSpaceShadingDoesNotShareTexelsBetweenSurfacesWithTheSameUVs) {
+		// two quads over the same uvs, the left one facing the light and the right one's normals facing away from it
+		Mesh mesh{};
+		const auto addQuad{ [&mesh](float minX, const Vector3& normal, const Vector3& tangent)
+			{
+				const uint32_t first{ uint32_t(mesh.vertices.size()) };
+				for (const Vector2& uv : { Vector2{ 0.f, 0.f }, Vector2{ 1.f, 0.f }, Vector2{ 0.f, 1.f }, Vector2{ 1.f, 1.f } })
+				{
+					const Vector3 position{ minX + uv.x * 5.f, 2.5f - uv.y * 5.f, 0.f };
+					mesh.vertices.push_back(Vertex{ position, colors::White, uv, normal, tangent });
+				}
+				for (uint32_t index : { 0u, 1u, 2u, 1u, 3u, 2u }) mesh.indices.push_back(first + index);
+			} };
+		addQuad(-6.f, { 0.f, 0.f, -1.f }, { 1.f, 0.f, 0.f });
+		addQuad(1.f, { 0.8f, 0.f, -0.6f }, { 0.6f, 0.f, 0.8f });
+
+		RendererComparison comparison{ std::vector<Mesh>{ mesh } };
+		comparison.renderer.ToggleTextureSpaceShading();
+		for (Renderer* pRenderer : { &comparison.reference, &comparison.renderer })
+		{
+			// without the normal map the lighting only depends on the interpolated normals
+			pRenderer->ToggleRotation();
+			pRenderer->ToggleUseNormals();
+			pRenderer->SetShadingMode(Renderer::ShadingMode::ObservedAreaOnly);
+		}
+		comparison.LookAt({ 0.f, 0.f, -20.f }, Vector3::Zero);
+		comparison.Render(0.f);
+		ASSERT_GT(comparison.renderer.GetFrameStatistics().fragments, 0u);
+
+		// the right quad would reuse the left quad's lighting if entries were only keyed by uv
+		EXPECT_LT(comparison.MeanDifference(), 0.1);
+	}
 }